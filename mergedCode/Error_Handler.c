@@ -12,6 +12,7 @@ Date: 18/04/2024
 #include "Error_Handler.h"
 #include "Utils.h"
 #include "extern_variables.h"
+#include "log.h"
 
 /* status_error_code messages */
 const char *msg[MSG_LEN] = {
@@ -27,6 +28,10 @@ const char *msg[MSG_LEN] = {
         "%s - Missing opening 'mcr' on line %d.",
         "%s - Missing closing 'endmcr' on line %d.",
         "%s - Invalid macro name (%s) on line %d.",
+        "%s - Macro (%s) is already defined, redefined on line %d.",
+        "%s - Invalid parameters of macro (%s) on line %d.",
+        "%s - Wrong number of arguments to macro (%s) on line %d.",
+        "Assembler - Unable to write the %s file.",
         "Preprocessor (%d/%d) - No output file(s) have been generated - %s.as.",
         "Preprocessor (%d/%d) - Output file(s) have been successfully generated - %s."
 };
@@ -37,10 +42,11 @@ const char *msg[MSG_LEN] = {
  * Handles different error codes and formats the error messages accordingly.
  * Additional arguments may be required for specific error messages.
  *
+ * @param ctx       The context of the file being assembled (NULL if there's none).
  * @param code      The error code indicating the type of error.
  * @param ...       Additional arguments depending on the error code.
  */
-void handle_preprocessor_error(status_error_code code, ...) {
+void handle_preprocessor_error(assembler_context *ctx, status_error_code code, ...) {
     va_list args;
     file_context *fc = NULL;
     int num, tot;
@@ -49,26 +55,37 @@ void handle_preprocessor_error(status_error_code code, ...) {
     va_start(args, code);
 
     if (code == FAILURE || code == ERR_MEM_ALLOC)
-        fprintf(stderr, code == ERR_MEM_ALLOC ? "ERROR ->\t%s" : "TERMINATED ->\t%s", msg[code]);
+        fprintf(ERR_STREAM(ctx), code == ERR_MEM_ALLOC ? "ERROR ->\t%s" : "TERMINATED ->\t%s", msg[code]);
     else if (code == TERMINATE || code == ERR_FOUND_ASSEMBLER) {
         fncall =  va_arg(args, char *);
-        fprintf(stderr, code == TERMINATE ? "INTERNAL ERROR ->\t" : "TERMINATED ->\t");
-        fprintf(stderr, msg[code], fncall);
+        fprintf(ERR_STREAM(ctx), code == TERMINATE ? "INTERNAL ERROR ->\t" : "TERMINATED ->\t");
+        fprintf(ERR_STREAM(ctx), msg[code], fncall);
     }
     else if (code >= ERR_OPEN_FILE && code <= ERR_MISSING_ENDMCR) {
-        fprintf(stderr, "ERROR ->\t");
+        fprintf(ERR_STREAM(ctx), "ERROR ->\t");
         fc = va_arg(args, file_context*);
-        fprintf(stderr, msg[code], fc->file_name, fc->lc);
+        fprintf(ERR_STREAM(ctx), msg[code], fc->file_name, fc->lc);
+    }
+    else if (code >= ERR_INVAL_MACRO_NAME && code <= ERR_MACRO_ARGUMENTS) {
+        fprintf(ERR_STREAM(ctx), "ERROR ->\t");
+        fc = va_arg(args, file_context*);
+        fncall = va_arg(args, char*);
+        fprintf(ERR_STREAM(ctx), msg[code], fc->file_name, fncall, fc->lc);
+    }
+    else if (code == ERR_WRITE_FILE) {
+        fprintf(ERR_STREAM(ctx), "ERROR ->\t");
+        fncall = va_arg(args, char*);
+        fprintf(ERR_STREAM(ctx), msg[code], fncall);
     }
     else if (code == ERR_PRE) {
-        fprintf(stderr, "ERROR ->\t");
+        fprintf(ERR_STREAM(ctx), "ERROR ->\t");
         num = va_arg(args, int);
         tot = va_arg(args, int);
         fncall = va_arg(args, char*);
-        fprintf(stderr, msg[code], num, tot, fncall);
+        fprintf(ERR_STREAM(ctx), msg[code], num, tot, fncall);
     }
     va_end(args);
-    fprintf(stderr, "\n");
+    fprintf(ERR_STREAM(ctx), "\n");
 }
 
 /**
@@ -77,226 +94,239 @@ void handle_preprocessor_error(status_error_code code, ...) {
  * Handles different progress codes and formats the progress messages accordingly.
  * Additional arguments may be required for specific progress messages.
  *
+ * @param ctx       The context of the file being assembled (NULL if there's none).
  * @param code      The progress code indicating the type of progress.
  * @param ...       Additional arguments depending on the progress code.
  */
-void handle_preprocessor_progress(status_error_code code, ...) {
+void handle_preprocessor_progress(assembler_context *ctx, status_error_code code, ...) {
     va_list args;
     file_context *fc;
     int num, tot;
 
+    if (!LOG_ENABLED(ctx, LOG_NORMAL))
+        return;
+
     va_start(args, code);
     if (code == NO_ERROR)
-        printf(msg[code], va_arg(args, char*));
+        fprintf(OUT_STREAM(ctx), msg[code], va_arg(args, char*));
     else {
         if (code <= OPEN_FILE) {
             fc = va_arg(args, file_context*);
-            printf(msg[code], fc->file_name);
+            fprintf(OUT_STREAM(ctx), msg[code], fc->file_name);
         }
         else if (code == PRE_FILE_OK) {
             fc = va_arg(args, file_context*);
             num = va_arg(args, int);
             tot = va_arg(args, int);
-            printf(msg[code], num, tot, fc->file_name);
+            fprintf(OUT_STREAM(ctx), msg[code], num, tot, fc->file_name);
         }
         else
-        fprintf(stderr, "INTERNAL ERROR ->\tInvalid function call - handle_preprocessor_progress()");
+        fprintf(ERR_STREAM(ctx), "INTERNAL ERROR ->\tInvalid function call - handle_preprocessor_progress()");
         va_end(args);
     }
-    printf("\n");
+    fprintf(OUT_STREAM(ctx), "\n");
 }
 
 
 /* This function receives line number as a parameter and prints a detailed error message
-   accordingly to the error global variable */
-void write_preprocessor_error(int line_num)
+   accordingly to the error of the given context */
+void write_preprocessor_error(assembler_context *ctx, int line_num)
 {
-    fprintf(stderr, "ERROR (line %d): ", line_num);
+    fprintf(ctx->err_stream, "ERROR (line %d): ", line_num);
 
-    switch (err)
+    switch (ctx->err)
     {
         case SYNTAX_ERR:
-            fprintf(stderr, "first non-blank character must be a letter or a dot.\n");
+            fprintf(ctx->err_stream, "first non-blank character must be a letter or a dot.\n");
 
             break;
 
         case LABEL_ALREADY_EXISTS:
-            fprintf(stderr, "label already exists.\n");
+            fprintf(ctx->err_stream, "label already exists.\n");
 
             break;
 
         case LABEL_TOO_LONG:
-            fprintf(stderr, "label is too long (LABEL_MAX_LENGTH: %d).\n", LABEL_LENGTH);
+            fprintf(ctx->err_stream, "label is too long (LABEL_MAX_LENGTH: %d).\n", LABEL_LENGTH);
 
             break;
 
         case LABEL_INVALID_FIRST_CHAR:
-            fprintf(stderr, "label must start with an alphanumeric character.\n");
+            fprintf(ctx->err_stream, "label must start with an alphanumeric character.\n");
 
             break;
 
         case LABEL_ONLY_ALPHANUMERIC:
-            fprintf(stderr, "label must only contain alphanumeric characters.\n");
+            fprintf(ctx->err_stream, "label must only contain alphanumeric characters.\n");
 
             break;
 
         case LABEL_CANT_BE_COMMAND:
-            fprintf(stderr, "label can't have the same name as a command.\n");
+            fprintf(ctx->err_stream, "label can't have the same name as a command.\n");
 
             break;
 
         case LABEL_CANT_BE_REGISTER:
-            fprintf(stderr, "label can't have the same name as a register.\n");
+            fprintf(ctx->err_stream, "label can't have the same name as a register.\n");
 
             break;
 
         case LABEL_ONLY:
-            fprintf(stderr, "label must be followed by a command or a directive.\n");
+            fprintf(ctx->err_stream, "label must be followed by a command or a directive.\n");
 
             break;
 
         case DIRECTIVE_NO_PARAMS:
-            fprintf(stderr, "directive must have parameters.\n");
+            fprintf(ctx->err_stream, "directive must have parameters.\n");
 
             break;
 
         case DIRECTIVE_INVALID_NUM_PARAMS:
-            fprintf(stderr, "illegal number of parameters for a directive.\n");
+            fprintf(ctx->err_stream, "illegal number of parameters for a directive.\n");
 
             break;
 
         case DATA_COMMAS_IN_A_ROW:
-            fprintf(stderr, "incorrect usage of commas in a .data directive.\n");
+            fprintf(ctx->err_stream, "incorrect usage of commas in a .data directive.\n");
 
             break;
 
         case DATA_EXPECTED_NUM_OR_CONST:
-            fprintf(stderr, ".data expected a numeric parameter or const\n");
+            fprintf(ctx->err_stream, ".data expected a numeric parameter or const\n");
 
             break;
 
         case DATA_EXPECTED_COMMA_AFTER_NUM:
-            fprintf(stderr, ".data expected a comma after a numeric parameter.\n");
+            fprintf(ctx->err_stream, ".data expected a comma after a numeric parameter.\n");
 
             break;
 
         case DATA_UNEXPECTED_COMMA:
-            fprintf(stderr, ".data got an unexpected comma after the last number.\n");
+            fprintf(ctx->err_stream, ".data got an unexpected comma after the last number.\n");
 
             break;
 
         case STRING_TOO_MANY_OPERANDS:
-            fprintf(stderr, ".string must contain exactly one parameter.\n");
+            fprintf(ctx->err_stream, ".string must contain exactly one parameter.\n");
 
             break;
 
         case STRING_OPERAND_NOT_VALID:
-            fprintf(stderr, ".string operand is invalid.\n");
+            fprintf(ctx->err_stream, ".string operand is invalid.\n");
 
             break;
 
         case STRUCT_INVALID_NUM:
-            fprintf(stderr, ".struct first parameter must be a number.\n");
+            fprintf(ctx->err_stream, ".struct first parameter must be a number.\n");
 
             break;
 
         case STRUCT_EXPECTED_STRING:
-            fprintf(stderr, ".struct must have 2 parameters.\n");
+            fprintf(ctx->err_stream, ".struct must have 2 parameters.\n");
 
             break;
 
         case STRUCT_INVALID_STRING:
-            fprintf(stderr, ".struct second parameter is not a string.\n");
+            fprintf(ctx->err_stream, ".struct second parameter is not a string.\n");
 
             break;
 
         case STRUCT_TOO_MANY_OPERANDS:
-            fprintf(stderr, ".struct must not have more than 2 operands.\n");
+            fprintf(ctx->err_stream, ".struct must not have more than 2 operands.\n");
 
             break;
 
         case EXPECTED_COMMA_BETWEEN_OPERANDS:
-            fprintf(stderr, ".struct must have 2 operands with a comma between them.\n");
+            fprintf(ctx->err_stream, ".struct must have 2 operands with a comma between them.\n");
 
             break;
 
         case EXTERN_NO_LABEL:
-            fprintf(stderr, ".extern directive must be followed by a label.\n");
+            fprintf(ctx->err_stream, ".extern directive must be followed by a label.\n");
 
             break;
 
         case EXTERN_INVALID_LABEL:
-            fprintf(stderr, ".extern directive received an invalid label.\n");
+            fprintf(ctx->err_stream, ".extern directive received an invalid label.\n");
 
             break;
 
         case EXTERN_TOO_MANY_OPERANDS:
-            fprintf(stderr, ".extern must only have one operand that is a label.\n");
+            fprintf(ctx->err_stream, ".extern must only have one operand that is a label.\n");
 
             break;
 
         case COMMAND_NOT_FOUND:
-            fprintf(stderr, "invalid command or directive.\n");
+            fprintf(ctx->err_stream, "invalid command or directive.\n");
 
             break;
 
         case COMMAND_UNEXPECTED_CHAR:
-            fprintf(stderr, "invalid syntax of a command.\n");
+            fprintf(ctx->err_stream, "invalid syntax of a command.\n");
 
             break;
 
         case COMMAND_TOO_MANY_OPERANDS:
-            fprintf(stderr, "command can't have more than 2 operands.\n");
+            fprintf(ctx->err_stream, "command can't have more than 2 operands.\n");
 
             break;
 
         case COMMAND_INVALID_METHOD:
-            fprintf(stderr, "operand has invalid addressing method.\n");
+            fprintf(ctx->err_stream, "operand has invalid addressing method.\n");
 
             break;
         case COMMAND_INVALID_INDEX:
-            fprintf(stderr,"invalid index or array name\n");
+            fprintf(ctx->err_stream,"invalid index or array name\n");
             break;
 
         case COMMAND_INVALID_NUMBER_OF_OPERANDS:
-            fprintf(stderr, "number of operands does not match command requirements.\n");
+            fprintf(ctx->err_stream, "number of operands does not match command requirements.\n");
 
             break;
 
         case COMMAND_INVALID_OPERANDS_METHODS:
-            fprintf(stderr, "operands' addressing methods do not match command requirements.\n");
+            fprintf(ctx->err_stream, "operands' addressing methods do not match command requirements.\n");
 
             break;
 
         case ENTRY_LABEL_DOES_NOT_EXIST:
-            fprintf(stderr, ".entry directive must be followed by an existing label.\n");
+            fprintf(ctx->err_stream, ".entry directive must be followed by an existing label.\n");
 
             break;
 
         case ENTRY_CANT_BE_EXTERN:
-            fprintf(stderr, ".entry can't apply to a label that was defined as external.\n");
+            fprintf(ctx->err_stream, ".entry can't apply to a label that was defined as external.\n");
 
             break;
 
         case COMMAND_LABEL_DOES_NOT_EXIST:
-            fprintf(stderr, "label does not exist.\n");
+            fprintf(ctx->err_stream, "label does not exist.\n");
             break;
         case METHOD_IMMEDIATE_INPUT_INVALID:
-            fprintf(stderr, "method immediate is not number or predefined const\n");
+            fprintf(ctx->err_stream, "method immediate is not number or predefined const\n");
             break;
 
         case CANNOT_OPEN_FILE:
-            fprintf(stderr, "there was an error while trying to open the requested file.\n");
+            fprintf(ctx->err_stream, "there was an error while trying to open the requested file.\n");
             break;
 
         case DEFINE_MISSING_EQUALS:
-            fprintf(stderr, "Define missing =.\n");
+            fprintf(ctx->err_stream, "Define missing =.\n");
             break;
         case DEFINE_INVALID_VALUE:
-            fprintf(stderr, "Define invalid values.\n");
+            fprintf(ctx->err_stream, "Define invalid values.\n");
             break;
         case DEFINE_INVALID_LABEL:
-            fprintf(stderr, "Define invalid LABEL.\n");
-            
+            fprintf(ctx->err_stream, "Define invalid LABEL.\n");
+            break;
+
+        case MEMORY_OVERFLOW:
+            fprintf(ctx->err_stream, "program is too large for the memory (%d words).\n", MEMORY_WORDS);
+            break;
+
+        case OUT_OF_MEMORY:
+            fprintf(ctx->err_stream, "not enough memory to assemble the program.\n");
+            break;
+
     }
 }
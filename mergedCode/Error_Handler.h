@@ -9,7 +9,7 @@ Date: 18/04/2024
 #ifndef ASSEMBLER_ERRORS_H
 #define ASSEMBLER_ERRORS_H
 
-#define MSG_LEN 14
+#define MSG_LEN 18
 extern const char *msg[MSG_LEN];
 
 typedef enum {
@@ -25,13 +25,18 @@ typedef enum {
     ERR_MISSING_MCR,
     ERR_MISSING_ENDMCR,
     ERR_INVAL_MACRO_NAME,
+    ERR_MACRO_REDEFINED,
+    ERR_INVAL_MACRO_PARAMS,
+    ERR_MACRO_ARGUMENTS,
+    ERR_WRITE_FILE,
     ERR_PRE,
     PRE_FILE_OK
 } status_error_code;
 
-void handle_preprocessor_error(status_error_code code, ...);
-void handle_preprocessor_progress(status_error_code code, ...);
-void write_preprocessor_error(int line_num); /* This function is called when an error output is needed */
+struct assembler_context;
+void handle_preprocessor_error(struct assembler_context *ctx, status_error_code code, ...);
+void handle_preprocessor_progress(struct assembler_context *ctx, status_error_code code, ...);
+void write_preprocessor_error(struct assembler_context *ctx, int line_num); /* This function is called when an error output is needed */
 
 
 #endif
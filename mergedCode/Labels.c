@@ -9,193 +9,208 @@ Date: 18/04/2024
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <stdarg.h>
 
 #include "utils.h"
-#include "extern_variables.h"
+#include "stats.h"
+#include "string_pool.h"
 
-/* This function offsets the addresses of a certain group of labels (data/instruction labels)
- * by a given delta (num).
+/* The symbol of a name id, or NO_SYMBOL if the name isn't a label */
+#define SYMBOL_OF(table, id) ((id) != NO_NAME && (id) < (table)->by_name_capacity ? (table)->by_name[id] : NO_SYMBOL)
+
+/* This function makes room in the arrays of the symbols for one more symbol.
+ * Returns FALSE if there's not enough memory (the arrays that already grew keep their symbols). */
+static boolean grow_symbols(symbol_table *table)
+{
+    int names_capacity = table->capacity, offsets_capacity = table->capacity, flags_capacity = table->capacity;
+
+    if(!ensure_capacity((void **) &table->names, table->count, &names_capacity, sizeof(int)) ||
+       !ensure_capacity((void **) &table->offsets, table->count, &offsets_capacity, sizeof(unsigned int)) ||
+       !ensure_capacity((void **) &table->flags, table->count, &flags_capacity, sizeof(unsigned char)))
+        return FALSE;
+    table->capacity = names_capacity;
+    return TRUE;
+}
+
+/* This function initializes an empty symbols table, whose names are interned in the given pool */
+void init_labels(symbol_table *table, string_pool *pool)
+{
+    int kind;
+
+    table->names = NULL;
+    table->offsets = NULL;
+    table->flags = NULL;
+    for(kind = 0; kind < NUM_SYMBOL_KINDS; kind++)
+        table->bases[kind] = 0;
+    table->count = table->capacity = 0;
+    table->pool = pool;
+    table->by_name = NULL;
+    table->by_name_capacity = 0;
+    table->lookups = 0;
+}
+
+/* This function places a segment (code/data labels) at a base address. The symbols aren't changed: the base is added
+ * whenever the value of a symbol of the segment is read. External labels (their address is 0) and constants (their
+ * value isn't an address) are never placed, so their base stays 0.
  */
-void offset_addresses(labelPtr label, int num, boolean is_data)
+void set_segment_base(symbol_table *table, int kind, unsigned int base)
 {
-    while(label)
-    {
-        /* We don't offset external labels (their address is 0). or define which its address is its value*/
-        /* is_data and inActionStatement must have different values in order to meet the same criteria
-         * and the XOR operator gives us that */
-        if(!(label -> external) && (is_data ^ (label -> inActionStatement)) && (strcmp(label->property,MDEFINE)!=0))
-        {
-            label -> address += num;
-        }
-        label = label -> next;
-    }
+    table->bases[kind] = base;
 }
 
-/* This function searches a label in the list and changes his entry field to TRUE and returns TRUE
+/* This function searches a label (by the id of its name) in the table and marks it as an entry and returns TRUE
 else if the label doesn't exist return FALSE. */
-int make_entry(labelPtr h, char *name)
+int make_entry(assembler_context *ctx, int name)
 {
-    labelPtr label = get_label(h, name);
-    if(label != NULL)
+    symbol_table *table = &ctx->symbols_table;
+    int symbol = get_label_of(table, name);
+    if(symbol != NO_SYMBOL)
     {
-        if(label -> external)
+        if(SYMBOL_KIND(table, symbol) == SYMBOL_EXTERN)
         {
-            err = ENTRY_CANT_BE_EXTERN;
+            ctx->err = ENTRY_CANT_BE_EXTERN;
             return FALSE;
         }
-        label -> entry = TRUE;
-        entry_exists = TRUE; /* Global variable that holds that there was at least one entry in the program */
+        table->flags[symbol] |= SYMBOL_ENTRY;
+        ctx->entry_exists = TRUE; /* Holds that there was at least one entry in the program */
         return TRUE;
     }
     else
-        err = ENTRY_LABEL_DOES_NOT_EXIST;
+        ctx->err = ENTRY_LABEL_DOES_NOT_EXIST;
     return FALSE;
 }
 
-/* This function returns the address of a given label, if the label doesn't exist return FALSE (0).*/
-unsigned int get_label_address(labelPtr h, char *name)
+/* This function returns the address of a given label (by the id of its name), if the label doesn't exist return FALSE (0).*/
+unsigned int get_label_address(symbol_table *table, int name)
 {
-    labelPtr label = get_label(h, name);
-    if(label != NULL) return label -> address;
+    int symbol = get_label_of(table, name);
+    if(symbol != NO_SYMBOL) return SYMBOL_VALUE(table, symbol);
     return FALSE;
 }
 
-/* This function check if a label is in the array and an external label is so return 1 else return 0 */
-boolean is_external_label(labelPtr h, char *name)
+/* This function check if a label is in the table and an external label is so return 1 else return 0 */
+boolean is_external_label(symbol_table *table, char *name)
 {
-    labelPtr label = get_label(h, name);
-    if(label != NULL) return label -> external;
+    int symbol = get_label(table, name);
+    if(symbol != NO_SYMBOL) return SYMBOL_KIND(table, symbol) == SYMBOL_EXTERN;
     return FALSE;
 }
 
-/* This function checks if a given name is a name of a label in the list */
-boolean is_existing_label(labelPtr h, char *name)
+/* This function checks if a given name is a name of a label in the table */
+boolean is_existing_label(symbol_table *table, char *name)
 {
-    return get_label(h, name) != NULL;
+    return get_label(table, name) != NO_SYMBOL;
 }
 
-/* This function checks if a given label name is in the list if so return 1 else return 0. */
-labelPtr get_label(labelPtr h, char *name)
+/* This function returns the symbol with the given name, or NO_SYMBOL if it isn't in the table */
+int get_label(symbol_table *table, char *name)
 {
-	while(h)
-	{
-        if(strcmp(h->name,name)==0) /* we found a label with the name given */
-			return h;
-		h=h->next;
-	}
-	return NULL;
+    return find_label(table, name, strlen(name));
 }
 
-/* This function adds a new label to the linked list of labels given its info. */
-labelPtr add_label(labelPtr *hptr, char *name, unsigned int address, char *property,boolean external, ...)
-{	
-	va_list p;
-	
-	labelPtr t=*hptr;
-	labelPtr temp; /* Auxiliary variable to store the info of the label and add to the list */
-
-	if(is_existing_label(*hptr, name))
-	{
-		err = LABEL_ALREADY_EXISTS;
-		return NULL;
-	}
-	temp=(labelPtr) malloc(sizeof(Labels)); 
-	if(!temp) /*if we couldn't allocate memory to temp then print an error massage and exit the program*/
-	{
-		printf("\nADD LABEL error, cannot allocate memory\n");
-		exit(ERROR);
-	}
+/* This function returns the symbol whose name is the given characters (not terminated by '\0', like a token
+ * of a line), or NO_SYMBOL if it isn't in the table */
+int find_label(symbol_table *table, const char *name, int len)
+{
+    table->lookups++;
+    if(table->count == 0)
+        return NO_SYMBOL;
+    return SYMBOL_OF(table, find_name(table->pool, name, len)); /* A name that was never seen isn't a label */
+}
 
-	/* Storing the info of the label in temp */
-    strcpy(temp->property, property);  /* Directly setting property from arguments*/
-    temp->entry = FALSE;
-    temp->next = NULL;
-	strcpy(temp->name, name);
-    temp -> entry = FALSE;
-	temp -> address = address;
-	temp -> external = external;
+/* This function returns the symbol with the given id of a name, or NO_SYMBOL if it isn't in the table */
+int get_label_of(symbol_table *table, int name)
+{
+    table->lookups++;
+    return SYMBOL_OF(table, name);
+}
 
+/* This function adds a new label to the symbols table given its name, offset in the segment of its kind, and kind
+ * (the name is given by its characters and their number, so it can be a token of a line).
+ * Returns the new symbol, or NO_SYMBOL (with the error in the context) if the label already exists or there's not
+ * enough memory. */
+int add_label(assembler_context *ctx, const char *name, int len, unsigned int offset, int kind)
+{
+	symbol_table *table = &ctx->symbols_table;
+	int id = intern_name(table->pool, name, len), symbol;
 
-	if(!external) /* An external label can't be in an action statement */
+	if(id != NO_NAME && get_label_of(table, id) != NO_SYMBOL)
 	{
-		va_start(p,external);
-		temp -> inActionStatement = va_arg(p,boolean);
+		ctx->err = LABEL_ALREADY_EXISTS;
+		return NO_SYMBOL;
 	}
-    else
-    {
-        extern_exists = TRUE;
-    }
-
-	/* If the list is empty then we set the head of the list to be temp */
-	if(!(*hptr))
-	{	
-		*hptr = temp;
-		temp -> next = NULL;
-		return temp;	
+	/* Making room for the symbol and for the slot of its name before it's added */
+	if(id == NO_NAME || !grow_name_index(&table->by_name, &table->by_name_capacity, table->pool->capacity, NO_SYMBOL) ||
+	   !grow_symbols(table))
+	{
+		ctx->err = OUT_OF_MEMORY;
+		return NO_SYMBOL;
 	}
 
-	/* Setting a pointer to go over the list until he points on the last label and then stting temp to be the new last label */
-	while(t -> next != NULL)
-		t = t->next;
-	temp -> next = NULL;
-	t -> next = temp;
+	/* The symbols are appended, so they stay in the order they were defined in */
+	symbol = table->count++;
+	table->names[symbol] = id;
+	table->offsets[symbol] = offset;
+	table->flags[symbol] = (unsigned char) kind;
+	table->by_name[id] = symbol;
+	if(kind == SYMBOL_EXTERN)
+		ctx->extern_exists = TRUE;
+	ctx->stats.symbols++;
+
+	return symbol;
+}
 
-	va_end(p);
-	return temp;
+/* This function sets the kind of a label and its offset in the segment of the kind (once the statement of its line
+ * is known) */
+void define_label(symbol_table *table, int symbol, unsigned int offset, int kind)
+{
+	table->offsets[symbol] = offset;
+	table->flags[symbol] = (unsigned char) ((table->flags[symbol] & ~SYMBOL_KIND_MASK) | kind);
 }
 
-/* This function frees the allocated memory for the symbols table*/
-void free_labels(labelPtr *hptr)
+/* This function frees the allocated memory for the symbols table, and empties it */
+void free_labels(symbol_table *table)
 {
-	/* Free the label list by going over each label and free it */
-	labelPtr temp;
-	while(*hptr)
-	{
-		temp=*hptr;
-		*hptr=(*hptr)->next;
-		free(temp);
-	}
+	unsigned long lookups = table->lookups;
+	free(table->names);
+	free(table->offsets);
+	free(table->flags);
+	free(table->by_name);
+	init_labels(table, table->pool);
+	table->lookups = lookups; /* The lookups are counted for the whole assembling of the file */
 }
 
-/* This function gets a label's name, searches the list for it and deletes the label.
+/* This function deletes a symbol from the table, keeping the order of the others.
  * If it managed to delete the label return 1 else return 0
  */
-int delete_label(labelPtr *hptr, char *name)
+int delete_label(symbol_table *table, int symbol)
 {
-    /* Goes over the label list and checking if a label by a given name is in the list if it is then deletes it by
-    free its space and change the previous label's pointer to point to the next label */
-    labelPtr temp = *hptr;
-    labelPtr prevtemp;
-    while (temp) {
-        if (strcmp(temp->name, name) == 0) {
-            if (strcmp(temp->name, (*hptr)->name) == 0) {
-                *hptr = (*hptr)->next;
-                free(temp);
-            } else {
-                prevtemp->next = temp->next;
-                free(temp);
-            }
-            return 1;
-        }
-        prevtemp = temp;
-        temp = temp->next;
-    }
-    return 0;
+    int i;
 
+    if(symbol == NO_SYMBOL || symbol >= table->count)
+        return 0;
+    table->by_name[table->names[symbol]] = NO_SYMBOL;
+
+    /* The symbols after it move back by one (it is usually the last one that was added) */
+    for(i = symbol + 1; i < table->count; i++)
+    {
+        table->names[i - 1] = table->names[i];
+        table->offsets[i - 1] = table->offsets[i];
+        table->flags[i - 1] = table->flags[i];
+        table->by_name[table->names[i - 1]] = i - 1;
+    }
+    table->count--;
+    return 1;
 }
 
-/* This function prints the list */
-void print_labels(labelPtr h)
+/* This function prints the table */
+void print_labels(symbol_table *table)
 {
-    while (h)
+    int i;
+    for(i = 0; i < table->count; i++)
     {
-        printf("\nname: %s, address: %d, external: %d", h->name, h->address, h->external);
-        if (h->external == 0)
-            printf(", is in action statement: %d -> ", h->inActionStatement);
-        else
-            printf(" -> ");
-        h = h->next;
+        printf("\nname: %s, value: %u, kind: %d", STRING_OF(table->pool, table->names[i]), SYMBOL_VALUE(table, i),
+               SYMBOL_KIND(table, i));
+        printf((table->flags[i] & SYMBOL_ENTRY) ? ", entry -> " : " -> ");
     }
     printf("*");
-}
\ No newline at end of file
+}
@@ -13,103 +13,166 @@ Date: 18/04/2024
 #include "PreProcessor.h"
 #include "Utils.h"
 #include "Error_Handler.h"
-
-node* macro_head = NULL; /* Head of the macros linked list */
-node* macro_tail = NULL; /* Tail of the macros linked list */
-
-#define HANDLE_REPORT if(report == ERR_MEM_ALLOC || report == TERMINATE) return TERMINATE; \
+#include "line_source.h"
+#include "keywords.h"
+#include "prototypes.h"
+#include "log.h"
+#include "stats.h"
+#include "arena.h"
+
+#define HANDLE_REPORT if(report == ERR_MEM_ALLOC || report == TERMINATE) break; \
 else if (report != NO_ERROR) found_error = 1;
 
 #define COUNT_SPACES(line_offset,line) while ((line)[line_offset] != '\0' && isspace((line)[line_offset])) \
 (line_offset)++;
 
-#define IS_EMPTY() (macro_head == NULL)
-
 /**
  * Processes the input source file for assembler preprocessing.
  *
- * Reads the source file, handles macros, and writes the preprocessed content to the destination file.
+ * Reads the source file to memory once, handles macros, and writes the preprocessed content to the source buffer of the context,
+ * which the assembler passes read from (the .am file is written from it only when it's asked for).
+ * When the context streams its source (--stream), the file is read line by line and every complete line of the source is
+ * passed to the first pass right away, so neither the file nor its preprocessed source is kept in memory.
  * Handle macro expansion, detection of line length errors, and reporting of errors.
  *
+ * @param ctx   Pointer to the assembler context of the file.
  * @param src   Pointer to the source file_context struct.
- * @param dest  Pointer to the destination file_context struct.
  *
  * @return      The status_error_code of the preprocessing operation.
  * @return NO_ERROR if successful, or an appropriate error status_error_code otherwise.
  */
-status_error_code assembler_preprocessor(file_context *src, file_context *dest) {
-    char line[MAX_BUFFER_LENGTH];
-    char *macro_name = NULL, *macro_body = NULL;
+status_error_code assembler_preprocessor(assembler_context *ctx, file_context *src) {
+    line_source lines;
+    char *line;
+    macro_definition definition;
     unsigned int line_len;
-    int found_macro = 0, found_error = 0, ch = -1;
-    status_error_code report;
+    int found_macro = 0, found_error = 0;
+    status_error_code report = NO_ERROR;
 
-    if (!src || !dest)
+    if (!src)
         return FAILURE; /* Unexpected error, probably unreachable */
-    rewind(src->file_ptr); /* make sure we read from the beginning */
-
-    while (fscanf(src->file_ptr, "%[^\n]%*c", line) == 1
-            || (ch = fgetc(src->file_ptr)) == '\n') {
+    if (ctx->stream)
+        stream_line_source(&lines, src->file_ptr);
+    else if ((report = read_line_source(&lines, src->file_ptr)) != NO_ERROR) {
+        if (report == ERR_MEM_ALLOC)
+            handle_preprocessor_error(ctx, ERR_MEM_ALLOC);
+        return TERMINATE;
+    }
+    definition.name = NO_NAME;
+    definition.num_params = 0;
+    init_text(&definition.body);
 
+    while ((line = next_line(&lines)) != NULL) {
+        ctx->stats.lines++;
         if (*line == ';')
             continue;
-        if (ch == '\n') {
-            fprintf(dest->file_ptr, "\n");
-            ch = -1;
-            continue;
+        if (*line == '\0') {
+            report = append_source(ctx, "\n", 1);
+            HANDLE_REPORT;
         }
-
-
-        line_len = strlen(line);
-        if (line_len > MAX_LINE_LENGTH) {
-            found_error = 1;
-            handle_preprocessor_error(ERR_LINE_TOO_LONG, src);
+        else {
+            line_len = strlen(line);
+            if (line_len > MAX_LINE_LENGTH) {
+                found_error = 1;
+                handle_preprocessor_error(ctx, ERR_LINE_TOO_LONG, src);
+            }
+            report = handle_macro_start(ctx, src, line, &found_macro, &definition);
+            HANDLE_REPORT;
+            report = handle_macro_body(ctx, line, found_macro, &definition.body);
+            HANDLE_REPORT;
+            report = handle_macro_end(ctx, src, line, &found_macro, &definition);
+            HANDLE_REPORT;
+            report = write_to_am(ctx, src, line, found_macro, found_error);
+            HANDLE_REPORT;
+
+            src->lc++;
         }
-        report = handle_macro_start(src, line, &found_macro, &macro_name, &macro_body);
-        HANDLE_REPORT;
-        report = handle_macro_body(line, found_macro, &macro_body);
-        HANDLE_REPORT;
-        report = handle_macro_end(line, &found_macro, &macro_name, &macro_body);
-        HANDLE_REPORT;
-        report = write_to_am_file(src, dest, line, found_macro, found_error);
-        HANDLE_REPORT;
-
-        src->lc++;
+        if (ctx->stream && !found_error) /* Passing the lines that are complete to the first pass */
+            stream_first_pass(ctx, FALSE);
     }
-    /* Reset line counter and rewind files */
-    dest->lc = 1;
-    rewind(dest->file_ptr);
-
-
-    if (found_error) { /* Error found, output file should be removed */
-        fclose(dest->file_ptr);
-        dest->file_ptr = NULL;
-        remove(dest->file_name);
+    if (lines.failed) { /* The rest of the file couldn't be read */
+        handle_preprocessor_error(ctx, ERR_MEM_ALLOC);
+        report = ERR_MEM_ALLOC;
     }
+    close_line_source(&lines);
+    free_text(&definition.body);
+    if (report == ERR_MEM_ALLOC || report == TERMINATE)
+        return TERMINATE;
+
+    if (ctx->stream && !found_error) /* The rest of the last line */
+        stream_first_pass(ctx, TRUE);
+    if (found_error) /* Error found, the preprocessed source shouldn't be assembled */
+        free_source(ctx);
 
-    free_macros();
+    free_macros(ctx);
     return found_error ? FAILURE : NO_ERROR;
 }
 
+/**
+ * Reads the parameters of a macro from the rest of its 'mcr' line: names separated by commas (there may be none).
+ * A name starts with a letter and continues with letters and digits, and a macro can't have two parameters with the same name.
+ * A name can't be a reserved word (a register, a command or a directive), since its words in the body would be replaced.
+ * The names are copied to the definition, since the body is split by them only after the 'mcr' line.
+ *
+ * @param ptr           The rest of the 'mcr' line, after the macro's name.
+ * @param definition    Pointer to the definition of the macro, where the parameters are stored.
+ *
+ * @return TRUE if the parameters are valid, FALSE otherwise.
+ */
+static boolean read_macro_params(char *ptr, macro_definition *definition) {
+    char *start, *name = definition->param_names;
+    int i;
+
+    definition->num_params = 0;
+    while (isspace(*ptr)) ptr++;
+    if (*ptr == '\0')
+        return TRUE;  /* A macro without parameters */
+
+    while (TRUE) {
+        while (isspace(*ptr)) ptr++;
+        start = ptr;
+        if (!isalpha(*ptr))
+            return FALSE;
+        while (isalnum(*ptr)) ptr++;
+
+        if (definition->num_params == MAX_MACRO_PARAMS || classify_keyword(start, ptr - start).kind != KEYWORD_IDENTIFIER)
+            return FALSE;
+        for (i = 0; i < definition->num_params; i++)
+            if (definition->params[i].len == ptr - start && memcmp(definition->params[i].start, start, ptr - start) == 0)
+                return FALSE;
+        if (name + (ptr - start) > definition->param_names + MAX_LINE_LENGTH)
+            return FALSE; /* Only the names of a line that's too long don't fit */
+        memcpy(name, start, ptr - start);
+        definition->params[definition->num_params++] = make_span(name, ptr - start);
+        name += ptr - start;
+
+        while (isspace(*ptr)) ptr++;
+        if (*ptr == '\0')
+            return TRUE;
+        if (*ptr++ != ',')
+            return FALSE;
+    }
+}
+
 /**
  * Handles the start of a macro definition in the input line.
  *
  * This function checks if the current line contains the start of a macro definition.
- * If a macro definition is found, it extracts the macro name and initializes the macro body.
+ * If a macro definition is found, it extracts the macro name and its parameters.
  * The function ensures that 'mcr' at the beginning or in the middle of a line is correctly recognized
  * only if it's followed by whitespace, distinguishing it from substrings in other identifiers.
  *
+ * @param ctx           Pointer to the assembler context of the file.
  * @param src           Pointer to the source file_context struct.
  * @param line          The input line to be processed.
  * @param found_macro   Pointer to a flag indicating whether a macro is found.
- * @param macro_name    Pointer to store the name of the macro.
- * @param macro_body    Pointer to store the body of the macro.
+ * @param definition    Pointer to store the name and the parameters of the macro.
  *
  * @return              The status_error_code of the handling operation.
  * @return NO_ERROR if successful, or an appropriate error status_error_code otherwise.
  */
-status_error_code handle_macro_start(file_context *src, char *line, int *found_macro,
-                                     char **macro_name, char **macro_body) {
+status_error_code handle_macro_start(assembler_context *ctx, file_context *src, char *line, int *found_macro,
+                                     macro_definition *definition) {
     char *mcr = NULL, *endmcr = NULL;
     char *prev_char = NULL, *post_char = NULL, *macro_name_start = NULL;
     size_t word_len;
@@ -136,10 +199,15 @@ status_error_code handle_macro_start(file_context *src, char *line, int *found_m
             word_len = mcr - macro_name_start;
 
             if (word_len > 0) {
-                *macro_name = (char*) malloc(word_len + 1);
-                if (!*macro_name) return ERR_MEM_ALLOC;  /* Handle memory allocation failure */
-                strncpy(*macro_name, macro_name_start, word_len);
-                (*macro_name)[word_len] = '\0';
+                ctx->macro_start = 1; /* This line isn't a part of the macro's body */
+                definition->name = intern_name(&ctx->names, macro_name_start, (int) word_len);
+                if (definition->name == NO_NAME) return ERR_MEM_ALLOC;  /* Handle memory allocation failure */
+
+                if (!read_macro_params(mcr, definition)) {
+                    definition->num_params = 0;
+                    handle_preprocessor_error(ctx, ERR_INVAL_MACRO_PARAMS, src, NAME_OF(ctx, definition->name));
+                    report = FAILURE;
+                }
             } else {
                 *found_macro = 0;  /* No valid macro name found, reset the flag */
                 return FAILURE;  /* Failure due to missing macro name */
@@ -149,7 +217,7 @@ status_error_code handle_macro_start(file_context *src, char *line, int *found_m
 
     /* Handle case where 'endmcr' is found but no corresponding 'mcr' */
     if (endmcr && !*found_macro) {
-        handle_preprocessor_error(ERR_MISSING_MCR, src);
+        handle_preprocessor_error(ctx, ERR_MISSING_MCR, src);
         return FAILURE;  /* Return failure due to missing start of macro definition */
     }
 
@@ -161,63 +229,35 @@ status_error_code handle_macro_start(file_context *src, char *line, int *found_m
  * Handles the body of a macro definition in the input line.
  *
  * Checks if the current line is part of a macro definition.
- * If a macro definition is ongoing, it appends the line to the macro body.
+ * If a macro definition is ongoing, it appends the line to the macro body
+ * (the body keeps its length, so a line is appended without scanning the body).
  *
+ * @param ctx           Pointer to the assembler context of the file.
  * @param line          The input line to be processed.
  * @param found_macro   Flag indicating whether a macro is found.
- * @param macro_body    Pointer to store the body of the macro.
+ * @param macro_body    Pointer to the body of the macro.
  *
  * @return              The status_error_code of the handling operation.
  * @return NO_ERROR if successful, or an appropriate error status_error_code otherwise.
  */
-status_error_code handle_macro_body(char *line, int found_macro, char **macro_body) {
-    static int macro_start = 0;
-    int line_offset;
-    char *new_macro_body = NULL;
-    unsigned int body_len, line_length;
+status_error_code handle_macro_body(assembler_context *ctx, char *line, int found_macro, text_buffer *macro_body) {
+    int line_offset = 0;
 
     if (!found_macro)
         return NO_ERROR;
-    if (*macro_body != NULL) {
-        macro_start = 0;
-        /* Adding to the body of a macro */
-        body_len = strlen(*macro_body);
-        line_offset = 0;
-        line_length = strlen(line);
-        COUNT_SPACES(line_offset, line);
-
-        if (strncmp(line + line_offset, "endmcr", SKIP_MCR_END) == 0)
-            return NO_ERROR;
-
-        new_macro_body = realloc(*macro_body, body_len + line_length - line_offset + 2);
-        if (new_macro_body == NULL) {
-            handle_preprocessor_error(ERR_MEM_ALLOC);
-            return ERR_MEM_ALLOC;
-        }
-
-        *macro_body = new_macro_body;
-        strncat(*macro_body, line + line_offset, line_length - line_offset);
-        strcat(*macro_body, "\n");
-    } else {
-        /* The beginning of a new macro's body */
-        line_offset = 0;
-        line_length = strlen(line);
-
-        COUNT_SPACES(line_offset, line);
-        if (macro_start == 0) {
-            macro_start = 1;
-            return NO_ERROR;
-        }
+    if (ctx->macro_start) { /* The line of 'mcr' */
+        ctx->macro_start = 0;
+        return NO_ERROR;
+    }
 
-        *macro_body = (char *)malloc(line_length - line_offset + 2);
-        if (*macro_body == NULL) {
-            handle_preprocessor_error(ERR_MEM_ALLOC);
-            return ERR_MEM_ALLOC;
-        }
+    COUNT_SPACES(line_offset, line);
+    if (strncmp(line + line_offset, ENDMCR, SKIP_MCR_END) == 0)
+        return NO_ERROR;
 
-        strncpy(*macro_body, line + line_offset, line_length - line_offset);
-        (*macro_body)[line_length - line_offset] = '\0';
-        strcat(*macro_body, "\n");
+    if (append_text(macro_body, line + line_offset, strlen(line + line_offset)) != NO_ERROR ||
+        append_text(macro_body, "\n", 1) != NO_ERROR) {
+        handle_preprocessor_error(ctx, ERR_MEM_ALLOC);
+        return ERR_MEM_ALLOC;
     }
     return NO_ERROR;
 }
@@ -228,16 +268,19 @@ status_error_code handle_macro_body(char *line, int found_macro, char **macro_bo
  * Checks if the current line marks the end of a macro definition.
  * If a macro definition is completed, it finalizes the macro body and updates the macro definition.
  *
+ * A macro that was already defined is reported when it's added to the macros table.
+ *
+ * @param ctx           Pointer to the assembler context of the file.
+ * @param src           Pointer to the source file_context struct.
  * @param line          The input line to be processed.
  * @param found_macro   Pointer to a flag indicating whether a macro is found.
- * @param macro_name    Pointer to store the name of the macro.
- * @param macro_body    Pointer to store the body of the macro.
+ * @param definition    Pointer to the definition of the macro, whose body is moved to the macros table.
  *
  * @return              The status_error_code of the handling operation.
  * @return NO_ERROR if successful, or an appropriate error status_error_code otherwise.
  */
-status_error_code handle_macro_end(char *line, int *found_macro,
-                        char **macro_name, char **macro_body) {
+status_error_code handle_macro_end(assembler_context *ctx, file_context *src, char *line, int *found_macro,
+                        macro_definition *definition) {
      char *ptr = strstr(line, ENDMCR);
     status_error_code report = NO_ERROR;
 
@@ -248,30 +291,83 @@ status_error_code handle_macro_end(char *line, int *found_macro,
         /* Check for any characters after 'endmcr' */
         while (*ptr && isspace(*ptr)) ptr++;
         if (*ptr != '\0') {
-            handle_preprocessor_error(ERR_EXTRA_TEXT, NULL);
-            return FAILURE;  /* Fail if there's extra text after 'endmcr' */
+            handle_preprocessor_error(ctx, ERR_EXTRA_TEXT, src);
+            report = FAILURE;  /* Fail if there's extra text after 'endmcr' */
         }
-
         /* Finalize the macro if not already done */
-        if (*macro_name && *macro_body) {
-            report = add_macro(*macro_name, *macro_body);
-            free(*macro_name);
-            free(*macro_body);
-            *macro_name = NULL;
-            *macro_body = NULL;
+        else if (definition->name != NO_NAME) {
+            report = add_macro(ctx, definition);
+            if (report == ERR_MACRO_REDEFINED) {
+                handle_preprocessor_error(ctx, ERR_MACRO_REDEFINED, src, NAME_OF(ctx, definition->name));
+                report = FAILURE;
+            }
         }
+        definition->body.len = 0; /* A body that wasn't moved to the table is reused by the next macro */
+        definition->name = NO_NAME;
+        definition->num_params = 0;
     }
 
     return report;
 }
 
 /**
- * Writes the preprocessed line to the destination file.
+ * Expands a call of a macro with parameters: the rest of the line is the arguments (separated by commas),
+ * and the pieces of the macro are appended with the arguments in the slots of the parameters.
+ *
+ * @param ctx   Pointer to the assembler context of the file.
+ * @param src   Pointer to the source file_context struct.
+ * @param m     The called macro.
+ * @param ptr   The rest of the line, after the macro's name.
+ *
+ * @return NO_ERROR if successful, FAILURE if the number of arguments is wrong, or TERMINATE.
+ */
+static status_error_code expand_macro(assembler_context *ctx, file_context *src, macro *m, char *ptr) {
+    span args[MAX_MACRO_PARAMS];
+    macro_piece *piece;
+    char *start, *end;
+    int num_args = 0, i;
+    status_error_code report = NO_ERROR;
+
+    while (isspace(*ptr)) ptr++;
+    while (*ptr != '\0') {
+        while (isspace(*ptr)) ptr++;
+        start = ptr;
+        while (*ptr != '\0' && *ptr != ',') ptr++;
+        end = ptr;
+        while (end > start && isspace(*(end - 1))) end--;
+        if (end == start || num_args == m->num_params) {
+            num_args = -1; /* An empty argument (or a comma after the last one), or too many arguments */
+            break;
+        }
+        args[num_args++] = make_span(start, end - start);
+        if (*ptr == ',' && *++ptr == '\0')
+            num_args = -1;
+    }
+    if (num_args != m->num_params) {
+        handle_preprocessor_error(ctx, ERR_MACRO_ARGUMENTS, src, NAME_OF(ctx, m->name));
+        return FAILURE;
+    }
+
+    for (i = 0; i < m->num_pieces && report == NO_ERROR; i++) {
+        piece = &m->pieces[i];
+        if (piece->param == NO_PARAM)
+            report = append_source(ctx, m->body + piece->start, piece->len);
+        else
+            report = append_source(ctx, args[piece->param].start, args[piece->param].len);
+    }
+    return report == NO_ERROR ? NO_ERROR : TERMINATE;
+}
+
+/**
+ * Writes the preprocessed line to the preprocessed source of the context.
  *
  * Performs additional checks to handle macro expansion and line length errors.
+ * The words are looked up where they are in the line (without copying them), and the text between the macros
+ * is appended in runs, so a line without macros is appended at once. The arguments of a call of a macro with parameters
+ * are the rest of its line.
  *
+ * @param ctx           Pointer to the assembler context of the file.
  * @param src           Pointer to the source file_context struct.
- * @param dest          Pointer to the destination file_context struct.
  * @param line          The input line to be processed.
  * @param found_macro   Flag indicating whether a macro is found.
  * @param found_error   Flag indicating whether an error is found.
@@ -279,10 +375,9 @@ status_error_code handle_macro_end(char *line, int *found_macro,
  * @return              The status_error_code of the writing operation.
  * @return NO_ERROR if successful, or an appropriate error status_error_code otherwise.
  */
-status_error_code write_to_am_file(file_context *src, file_context *dest, char *line, int found_macro, int found_error) {
-    int line_offset;
-    char *ptr = NULL, *word = NULL;
-    node *matched_macro = NULL;
+status_error_code write_to_am(assembler_context *ctx, file_context *src, char *line, int found_macro, int found_error) {
+    char *ptr = NULL, *run = NULL; /* The current word, and the start of the text that wasn't appended yet */
+    macro *matched_macro = NULL;
     size_t word_len;
 
     if (found_error)
@@ -290,136 +385,224 @@ status_error_code write_to_am_file(file_context *src, file_context *dest, char *
     if (found_macro) /* In the middle of processing a macro, no need to write the line */
         return NO_ERROR;
 
-    line_offset = 0;
-    while (isspace(line[line_offset])) {
-        line_offset++;
-    }
-    ptr = line + line_offset;
-    while (*ptr != '\0') {
-        while (isspace(*ptr)) {
-            fprintf(dest->file_ptr, "%c", *ptr);
-            ptr++;
-        }
-        if (*ptr == '\0')
-            break;
-        word_len = get_word_length(&ptr);
-        if (copy_n_string(&word, ptr, word_len) != NO_ERROR) {
-            free(word);
-            return TERMINATE;
-        }
+    ptr = line;
+    while (isspace(*ptr))
+        ptr++;
+    run = ptr;
+    while ((word_len = get_word_length(&ptr)) > 0) {
         found_macro = 0;
 
-        if ((matched_macro = is_macro_exists(word))) {
-                /* Replace the macro name with the macro body */
-                found_macro = 1;
-                fprintf(dest->file_ptr, "%s", matched_macro->body);
+        if ((matched_macro = find_macro(ctx, ptr, word_len))) {
+            /* Replace the macro name with the macro body */
+            found_macro = 1;
+            ctx->stats.macros_expanded++;
+            if (append_source(ctx, run, ptr - run) != NO_ERROR)
+                return TERMINATE;
+            if (matched_macro->num_params > 0)
+                return expand_macro(ctx, src, matched_macro, ptr + word_len);
+            if (matched_macro->body_len > 0 && append_source(ctx, matched_macro->body, matched_macro->body_len) != NO_ERROR)
+                return TERMINATE;
+            run = ptr + word_len;
         }
-        if (strncmp(word, ENDMCR,SKIP_MCR) == 0) {
-            ptr += SKIP_MCR_END;
-            line_offset = 0;
-            COUNT_SPACES(line_offset, ptr);
-            free(word);
-            return NO_ERROR;
-    }
-        else if (strcmp(word, MCR_START) == 0) {
-            printf("handle macro ERROR START 4");
-            handle_preprocessor_error(ERR_EXTRA_TEXT, src); /* Extraneous text after macro call */
-            free(word);
+        else if (word_len == SKIP_MCR_END && strncmp(ptr, ENDMCR, SKIP_MCR_END) == 0) {
+            /* The end of a macro's definition isn't written */
+            return append_source(ctx, run, ptr - run) == NO_ERROR ? NO_ERROR : TERMINATE;
+        }
+        else if (word_len == SKIP_MCR && strncmp(ptr, MCR_START, SKIP_MCR) == 0) {
+            log_message(ctx, LOG_TRACE, "handle macro ERROR START 4");
+            handle_preprocessor_error(ctx, ERR_EXTRA_TEXT, src); /* Extraneous text after macro call */
             return FAILURE;
         }
 
-        if (!found_macro)
-            fprintf(dest->file_ptr, "%s", word);
-        if (word) free(word);
-
         /* Move the pointer to the next word */
         ptr += word_len;
     }
+    if (append_source(ctx, run, ptr - run) != NO_ERROR) /* The rest of the line */
+        return TERMINATE;
     if (!found_macro){
-        printf("%s\n", line);
-        fprintf(dest->file_ptr, "\n");
+        if (LOG_ENABLED(ctx, LOG_TRACE))
+            log_message(ctx, LOG_TRACE, "%s\n", line);
+        if (append_source(ctx, "\n", 1) != NO_ERROR)
+            return TERMINATE;
     }
     return NO_ERROR;
 }
 
 /**
-* Adds a new macro with the given name and body to the global linked list of macros.
-*
-* @param name The name of the macro to add.
-* @param body The body of the macro to add.
-*
-* @return status_error_code, NO_ERROR in case of no error otherwise else the error status_error_code.
+ * Initializes an empty macros table.
+ *
+ * @param table The macros table.
  */
-status_error_code add_macro(char* name, char* body) {
-    status_error_code s_name, s_body;
-    node* new_macro = malloc(sizeof(node));
-
-    if (!new_macro) {
-        handle_preprocessor_error(ERR_MEM_ALLOC);
-        return ERR_MEM_ALLOC;
-    }
-
-    new_macro->name = NULL; /* Set name pointer to NULL to ensure proper initialization */
-    new_macro->body = NULL; /* Set body pointer to NULL to ensure proper initialization */
+void init_macros(macro_table *table) {
+    table->macros = NULL;
+    table->count = table->capacity = 0;
+    table->by_name = NULL;
+    table->by_name_capacity = 0;
+}
 
-    s_name = copy_string(&new_macro->name, name);
-    s_body = copy_string(&new_macro->body, body);
+/**
+ * Returns the macro of a name.
+ *
+ * @param table The macros table.
+ * @param name  The id of the name, or NO_NAME.
+ *
+ * @return A pointer to the macro if the name is a macro's name, or NULL otherwise.
+ */
+static macro *macro_of(macro_table *table, int name) {
+    if (name == NO_NAME || name >= table->by_name_capacity || table->by_name[name] == NO_MACRO)
+        return NULL;
+    return &table->macros[table->by_name[name]];
+}
 
-    if (s_name != NO_ERROR || s_body != NO_ERROR) {
-       if (new_macro->name) free(new_macro->name);
-       if (new_macro->body) free(new_macro->body);
-        free(new_macro);
-        return TERMINATE;
+/**
+ * Adds a piece to the expansion of a macro. While the pieces are only counted (the macro has no array yet),
+ * the piece isn't stored.
+ *
+ * @param m         The macro.
+ * @param start     Offset of the chunk in the body (for a chunk).
+ * @param len       Number of characters of the chunk (for a chunk).
+ * @param param     Index of the parameter, or NO_PARAM for a chunk of the body.
+ */
+static void add_macro_piece(macro *m, int start, int len, int param) {
+    if (m->pieces) {
+        m->pieces[m->num_pieces].start = start;
+        m->pieces[m->num_pieces].len = len;
+        m->pieces[m->num_pieces].param = param;
     }
+    m->num_pieces++;
+}
 
-    new_macro->next = NULL;
+/**
+ * Splits the body of a macro with parameters to chunks of text and the slots of the parameters (the words of the body
+ * that are the names of parameters), and adds them to the pieces of the macro. The text of a string literal is kept
+ * as it is, so a parameter isn't replaced inside quotes.
+ *
+ * @param m             The macro.
+ * @param definition    The definition of the macro (the names of its parameters).
+ */
+static void split_macro_body(macro *m, macro_definition *definition) {
+    char *ptr = m->body, *end = m->body + m->body_len, *word, *chunk = m->body;
+    int i;
 
-    if (IS_EMPTY()) {
-        macro_head = new_macro;
-        macro_tail = new_macro;
-    } else {
-        macro_tail->next = new_macro;
-        macro_tail = new_macro;
+    while (ptr < end) {
+        if (*ptr == '"') { /* Skipping the string literal, up to its closing quote or the end of its line */
+            ptr++;
+            while (ptr < end && *ptr != '"' && *ptr != '\n') ptr++;
+            if (ptr < end && *ptr == '"') ptr++;
+            continue;
+        }
+        if (!isalnum(*ptr)) {
+            ptr++;
+            continue;
+        }
+        word = ptr;
+        while (ptr < end && isalnum(*ptr)) ptr++;
+
+        for (i = 0; i < definition->num_params; i++)
+            if (definition->params[i].len == ptr - word && memcmp(definition->params[i].start, word, ptr - word) == 0)
+                break;
+        if (i < definition->num_params) {
+            if (word > chunk)
+                add_macro_piece(m, chunk - m->body, word - chunk, NO_PARAM);
+            add_macro_piece(m, 0, 0, i);
+            chunk = ptr;
+        }
     }
-    return NO_ERROR;
+    if (end > chunk)
+        add_macro_piece(m, chunk - m->body, end - chunk, NO_PARAM);
 }
 
 /**
- * Checks if a macro with the given name exists.
+ * Compiles the body of a macro with parameters to its pieces, so a call is expanded by concatenating the pieces
+ * instead of searching the body. The pieces are counted first, so their array is allocated in the arena at its size.
  *
- * @param name The name of the macro to check.
+ * @param objects       The arena of the context.
+ * @param m             The macro, after its body was moved to it.
+ * @param definition    The definition of the macro (the names of its parameters).
  *
- * @return A pointer to the matching macro if found, or NULL otherwise.
+ * @return FALSE if there's not enough memory, TRUE otherwise.
+ */
+static boolean compile_macro(arena *objects, macro *m, macro_definition *definition) {
+    m->num_params = definition->num_params;
+    m->pieces = NULL;
+    m->num_pieces = 0;
+    if (m->num_params == 0)
+        return TRUE; /* The body is expanded as is */
+
+    split_macro_body(m, definition);
+    m->pieces = (macro_piece *) arena_alloc(objects, m->num_pieces * sizeof(macro_piece));
+    if (m->pieces == NULL)
+        return FALSE;
+    m->num_pieces = 0;
+    split_macro_body(m, definition);
+    return TRUE;
+}
+
+/**
+* Adds a new macro with the given name and body to the context's macros table.
+* The buffer of the body is moved to the table without copying it, and the definition is left with an empty body
+* for the next macro. The body of a macro with parameters is compiled to its pieces.
+*
+* @param ctx The assembler context that holds the macros.
+* @param definition The definition of the macro to add (its name, parameters and body).
+*
+* @return status_error_code, NO_ERROR in case of no error, ERR_MACRO_REDEFINED if there's already a macro with that name,
+* otherwise else the error status_error_code.
  */
-node* is_macro_exists(char* name) {
-    node* current = macro_head;
+status_error_code add_macro(assembler_context *ctx, macro_definition *definition) {
+    macro_table *table = &ctx->macros;
+    macro *new_macro;
+
+    if (macro_of(table, definition->name))
+        return ERR_MACRO_REDEFINED;
+    if (!grow_name_index(&table->by_name, &table->by_name_capacity, ctx->names.capacity, NO_MACRO) ||
+        !ensure_capacity((void **) &table->macros, table->count, &table->capacity, sizeof(macro))) {
+        handle_preprocessor_error(ctx, ERR_MEM_ALLOC);
+        return ERR_MEM_ALLOC;
+    }
 
-    while (current && !IS_EMPTY()) {
-        if (strcmp(current->name, name) == 0)
-            return current; /* matching macro found */
-        current = current->next;
+    new_macro = &table->macros[table->count];
+    new_macro->name = definition->name;
+    new_macro->body = definition->body.text;
+    new_macro->body_len = definition->body.len;
+    if (!compile_macro(&ctx->objects, new_macro, definition)) {
+        handle_preprocessor_error(ctx, ERR_MEM_ALLOC);
+        return ERR_MEM_ALLOC; /* The body still belongs to the definition */
     }
 
-    return NULL; /* no matching macro found */
+    init_text(&definition->body); /* The body belongs to the table now */
+    table->by_name[definition->name] = table->count++;
+    return NO_ERROR;
 }
 
 /**
- * Frees the memory allocated for the linked list of macros,
- * including the memory allocated for macro names and bodies.
- * After freeing the memory, the macro list is empty.
+ * Finds the macro with the given name.
+ *
+ * @param ctx The assembler context that holds the macros.
+ * @param name The characters of the name (they don't have to be terminated by '\0').
+ * @param len The number of characters of the name.
+ *
+ * @return A pointer to the matching macro if found, or NULL otherwise.
  */
-void free_macros() {
-    node* current = macro_head;
-    node* next;
-
-    while (current && !IS_EMPTY()) {
-        next = current->next;
-        free(current->name);
-        free(current->body);
-        free(current);
-        current = next;
-    }
+macro* find_macro(assembler_context *ctx, const char* name, int len) {
+    if (ctx->macros.count == 0)
+        return NULL; /* Most sources have no macros, so their words aren't looked up in the names pool */
+    return macro_of(&ctx->macros, find_name(&ctx->names, name, len));
+}
 
-    macro_head = NULL;
-    macro_tail = NULL;
-}
\ No newline at end of file
+/**
+ * Frees the memory allocated for the macros table and the bodies of the macros. The names of the macros belong to
+ * the names pool of the context, and their pieces to its arena, which release them at the end of the file.
+ * After freeing the memory, the macros table is empty.
+ *
+ * @param ctx The assembler context that holds the macros.
+ */
+void free_macros(assembler_context *ctx) {
+    int i;
+
+    for (i = 0; i < ctx->macros.count; i++)
+        free(ctx->macros.macros[i].body);
+    free(ctx->macros.macros);
+    free(ctx->macros.by_name);
+    init_macros(&ctx->macros);
+}
@@ -19,24 +19,27 @@ Date: 18/04/2024
 #define SKIP_MCR 3 /* mcr length */
 #define SKIP_MCR_END 6 /* endmcr length */
 
-
-typedef struct node{
-    char* name;
-    char* body;
-    struct node* next;
-} node;
-
-
-status_error_code assembler_preprocessor(file_context *src, file_context *dest);
-
-status_error_code handle_macro_start(file_context *src, char *line, int *found_macro, char **macro_name, char **macro_body);
-status_error_code handle_macro_body(char *line, int found_macro, char **macro_body);
-status_error_code handle_macro_end(char *line, int *found_macro, char **macro_name, char **macro_body);
-status_error_code write_to_am_file(file_context *src, file_context *dest, char *line, int found_macro, int found_error);
-status_error_code add_macro(char* name, char* body);
-
-node* is_macro_exists(char* name);
-
-void free_macros();
+/* A macro whose definition is being read: 'mcr name p1, p2' starts a macro with the parameters p1 and p2,
+ * and a call 'name a1, a2' is replaced by the body where every whole word p1 is a1 and every whole word p2 is a2 */
+typedef struct macro_definition {
+    int name; /* the id of the macro's name in the names pool, NO_NAME while no macro is defined */
+    span params[MAX_MACRO_PARAMS]; /* the names of the parameters (in param_names) */
+    char param_names[MAX_LINE_LENGTH]; /* the names of the parameters, copied from the 'mcr' line (a streamed line is reused) */
+    int num_params; /* number of parameters */
+    text_buffer body; /* the body that was read so far */
+} macro_definition;
+
+status_error_code assembler_preprocessor(assembler_context *ctx, file_context *src);
+
+status_error_code handle_macro_start(assembler_context *ctx, file_context *src, char *line, int *found_macro, macro_definition *definition);
+status_error_code handle_macro_body(assembler_context *ctx, char *line, int found_macro, text_buffer *macro_body);
+status_error_code handle_macro_end(assembler_context *ctx, file_context *src, char *line, int *found_macro, macro_definition *definition);
+status_error_code write_to_am(assembler_context *ctx, file_context *src, char *line, int found_macro, int found_error);
+void init_macros(macro_table *table);
+status_error_code add_macro(assembler_context *ctx, macro_definition *definition);
+
+macro* find_macro(assembler_context *ctx, const char* name, int len);
+
+void free_macros(assembler_context *ctx);
 
 #endif
@@ -0,0 +1,72 @@
+/*=======================================================================================================
+Project: Maman 14 - Assembler
+Created by:
+Edrehy Tal and Liberman Ron Rafail
+
+Date: 18/04/2024
+Description: The arena of an assembly. The objects that live until the end of assembling a file (the pieces of the
+macros) are allocated one after the other in big chunks, instead of allocating and freeing each one of them, and all
+of them are released together when the file is done.
+========================================================================================================= */
+
+#include <stdlib.h>
+
+#include "arena.h"
+#include "stats.h"
+
+/* Every object starts at a multiple of the strictest alignment of the basic types */
+typedef union arena_align {
+    long l;
+    double d;
+    void *p;
+} arena_align;
+
+#define ALIGN_UP(size) (((size) + sizeof(arena_align) - 1) / sizeof(arena_align) * sizeof(arena_align))
+#define CHUNK_DATA(chunk) ((char *) (chunk) + ALIGN_UP(sizeof(arena_chunk))) /* The objects follow the chunk */
+
+/* This function initializes an empty arena (its first chunk is allocated with its first object) */
+void init_arena(arena *a)
+{
+    a->chunks = NULL;
+}
+
+/* This function allocates an object of the given size in the arena. If the current chunk is full, a new chunk that
+ * is twice as big (and at least big enough for the object) becomes the current one.
+ * Returns NULL if there's not enough memory. */
+void *arena_alloc(arena *a, size_t size)
+{
+    arena_chunk *chunk = a->chunks;
+    size_t chunk_size;
+    void *object;
+
+    size = ALIGN_UP(size);
+    if (chunk == NULL || chunk->size - chunk->used < size) {
+        chunk_size = chunk ? chunk->size * 2 : ARENA_INITIAL_SIZE;
+        if (chunk_size < size)
+            chunk_size = size;
+        chunk = (arena_chunk *) malloc(ALIGN_UP(sizeof(arena_chunk)) + chunk_size);
+        if (chunk == NULL)
+            return NULL;
+        count_allocation();
+        chunk->size = chunk_size;
+        chunk->used = 0;
+        chunk->next = a->chunks;
+        a->chunks = chunk;
+    }
+    object = CHUNK_DATA(chunk) + chunk->used;
+    chunk->used += size;
+    return object;
+}
+
+/* This function releases all the objects of the arena at once (the chunks double in size, so there are only a few
+ * of them), and the arena is empty afterwards */
+void free_arena(arena *a)
+{
+    arena_chunk *chunk;
+
+    while (a->chunks) {
+        chunk = a->chunks;
+        a->chunks = chunk->next;
+        free(chunk);
+    }
+}
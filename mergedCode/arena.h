@@ -0,0 +1,19 @@
+/*=======================================================================================================
+Project: Maman 14 - Assembler
+Created by:
+Edrehy Tal and Liberman Ron Rafail
+
+Date: 18/04/2024
+========================================================================================================= */
+
+#ifndef ASSEMBLER_ARENA_H
+#define ASSEMBLER_ARENA_H
+
+#include <stddef.h>
+#include "structs.h"
+
+void init_arena(arena *a);
+void *arena_alloc(arena *a, size_t size);
+void free_arena(arena *a);
+
+#endif
@@ -31,12 +31,13 @@ Date: 18/04/2024
 #define MIN_REGISTER 0 /* r0 is the first CPU register */
 #define MAX_REGISTER 7 /* r7 is the last CPU register */
 #define MAX_OP_LENGTH 20 /* minimum label length*/
-#define MAX_Property_length 7 /*the length of mdfide*/
 
 
 #define MAX_EXTENSION_LENGTH 5
 
-#define base4_SEQUENCE_LENGTH 8 /* A base4 sequence of a word consists of 2 digits (and '\0' ending) */
+#define base4_SEQUENCE_LENGTH 7 /* A base4 sequence of a word consists of 7 digits */
+#define MAX_DECIMAL_LENGTH 10 /* maximum number of digits of an unsigned int */
+#define OB_LINE_MAX_LENGTH (MAX_DECIMAL_LENGTH + 1 + base4_SEQUENCE_LENGTH + 1) /* address, tab, word and '\n' */
 
 
 #define NUM_DIRECTIVES 5 /* number of existing directives*/
@@ -64,8 +65,23 @@ Date: 18/04/2024
 #define DEST_METHOD_END_POS 3
 
 #define MACHINE_RAM 4096 /*Maximum Ram capacity*/
-
-#define MDEFINE "mdefine"
+#define MEMORY_WORDS (MACHINE_RAM - MEMORY_START) /* number of words that a program can use (instructions and data) */
+
+#define NAMES_INITIAL_BUCKETS 64 /* initial number of buckets in the hash table of the names pool */
+#define ARRAY_INITIAL_CAPACITY 64 /* initial number of elements of a growing array (decoded instructions, entries) */
+#define NAMES_INITIAL_CAPACITY 1024 /* initial number of characters of the names pool */
+#define NO_NAME -1 /* a name that isn't in the names pool */
+#define TEXT_INITIAL_CAPACITY 256 /* initial size of a growing text buffer (the preprocessed source, a macro's body) */
+#define ARENA_INITIAL_SIZE 4096 /* size of the first chunk of an arena (every chunk is twice as big as the last one) */
+#define NO_SYMBOL -1 /* an operand that doesn't refer to a label */
+#define NO_EXT -1 /* a name that isn't of an external label that was used */
+#define NO_MACRO -1 /* a name that isn't the name of a macro (in the index of the macros by name) */
+#define NO_PARAM -1 /* a piece of a macro's expansion that is a chunk of its body */
+#define NO_PHASE -1 /* no phase of assembling a file is running (--stats) */
+#define MAX_MACRO_PARAMS 8 /* maximal number of parameters of a macro */
+
+#define SYMBOL_KIND_MASK 0x03 /* the bits of the flags of a symbol that are its kind (enum symbol_kinds) */
+#define SYMBOL_ENTRY 0x04 /* the flag of a symbol that is an entry */
 
 /**************************************** Enums ****************************************/
 
@@ -87,12 +103,17 @@ enum errors {
     COMMAND_NOT_FOUND, COMMAND_UNEXPECTED_CHAR, COMMAND_TOO_MANY_OPERANDS,
     COMMAND_INVALID_METHOD, COMMAND_INVALID_NUMBER_OF_OPERANDS, COMMAND_INVALID_OPERANDS_METHODS,
     ENTRY_LABEL_DOES_NOT_EXIST, ENTRY_CANT_BE_EXTERN, COMMAND_LABEL_DOES_NOT_EXIST,
-    CANNOT_OPEN_FILE,COMMAND_INVALID_INDEX,DEFINE_MISSING_EQUALS,DEFINE_INVALID_VALUE,DEFINE_INVALID_LABEL,METHOD_IMMEDIATE_INPUT_INVALID
+    CANNOT_OPEN_FILE,COMMAND_INVALID_INDEX,DEFINE_MISSING_EQUALS,DEFINE_INVALID_VALUE,DEFINE_INVALID_LABEL,METHOD_IMMEDIATE_INPUT_INVALID,
+    MEMORY_OVERFLOW, OUT_OF_MEMORY
 };
 
 /* When we need to specify if label should contain a colon or not */
 enum {NO_COLON, COLON};
 
+/* The kinds of symbols, which are also the segments of their values. A label is a data label until its line turns out
+ * to be a command */
+enum symbol_kinds {SYMBOL_DATA, SYMBOL_CODE, SYMBOL_EXTERN, SYMBOL_CONSTANT, NUM_SYMBOL_KINDS};
+
 /* Addressing methods ordered by their code */
 enum methods {METHOD_IMMEDIATE, METHOD_DIRECT, METHOD_INDEX, METHOD_REGISTER, METHOD_UNKNOWN};
 
@@ -0,0 +1,365 @@
+/*=======================================================================================================
+Project: Maman 14 - Assembler
+Created by:
+Edrehy Tal and Liberman Ron Rafail
+
+Date: 18/04/2024
+Description: A generator of synthetic assembly programs for benchmarking the assembler. The programs are valid
+(they assemble without errors) and their shape is given by the parameters: the number of lines, labels, constants
+and macros, the share of externals and entries, the share of data directives and the mix of addressing methods.
+The same parameters and seed always generate the same program.
+========================================================================================================= */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../structs.h"
+
+#define MAX_DATA_NUMBERS 8 /* maximal number of numbers of a generated .data directive (so lines stay short) */
+#define MAX_STRING_LENGTH 12 /* maximal number of characters of a generated .string directive */
+#define NUM_METHODS 4 /* immediate, direct, index and register addressing */
+#define NUM_OPCODES 16
+
+/* The parameters of a generated program */
+typedef struct workload {
+    long lines; /* statements (commands and data directives) outside the macros */
+    long labels; /* labels that are defined on the statements */
+    long constants; /* .define constants */
+    long macros; /* macros that are defined */
+    long body; /* statements of the body of every macro */
+    long calls; /* calls of the macros (each one is replaced by the body of its macro) */
+    int extern_percent; /* external labels, in percents of the labels */
+    int entry_percent; /* .entry directives, in percents of the labels */
+    int data_percent; /* data directives, in percents of the statements */
+    int string_percent; /* .string directives, in percents of the data directives */
+    int method_weights[NUM_METHODS]; /* the relative frequency of every addressing method of the operands */
+    unsigned long seed; /* seed of the random numbers */
+} workload;
+
+/* The names of the commands, by their opcode (see enum commands) */
+static const char *opcode_names[NUM_OPCODES] = {"mov", "cmp", "add", "sub", "not", "clr", "lea", "inc",
+                                                "dec", "jmp", "bne", "red", "prn", "jsr", "rts", "hlt"};
+
+static unsigned long random_state;
+static long words; /* words of the memory image of the program generated so far */
+
+/* This function returns a random number in [0, n) (a linear congruential generator, so the programs don't depend on
+ * the C library) */
+static long random_below(long n)
+{
+    random_state = (random_state * 1103515245UL + 12345UL) & 0x7fffffffUL;
+    return n > 0 ? (long) ((random_state >> 8) % (unsigned long) n) : 0;
+}
+
+/* This function returns TRUE with the given probability (in percents) */
+static boolean random_percent(int percent)
+{
+    return random_below(100) < percent;
+}
+
+/* This function checks if an addressing method is accepted by a command for its source or destination operand
+ * (the same rules as command_accept_methods of the first pass) */
+static boolean accepts_method(int opcode, boolean is_dest, int method)
+{
+    switch (opcode) {
+        case MOV: case ADD: case SUB:
+            return !is_dest || method != METHOD_IMMEDIATE;
+        case LEA:
+            return is_dest ? method != METHOD_IMMEDIATE : method == METHOD_DIRECT || method == METHOD_INDEX;
+        case NOT: case CLR: case INC: case DEC: case RED:
+            return method != METHOD_IMMEDIATE;
+        case JMP: case BNE: case JSR:
+            return method == METHOD_DIRECT || method == METHOD_REGISTER;
+        default: /* cmp and prn accept every method */
+            return TRUE;
+    }
+}
+
+/* This function chooses the addressing method of an operand by the weights of the workload, among the methods that
+ * the command accepts (methods that refer to labels are left out when there are no labels) */
+static int choose_method(const workload *w, int opcode, boolean is_dest)
+{
+    int weights[NUM_METHODS], total = 0, method;
+    long pick;
+
+    for (method = 0; method < NUM_METHODS; method++) {
+        weights[method] = accepts_method(opcode, is_dest, method) ? w->method_weights[method] : 0;
+        if ((method == METHOD_DIRECT || method == METHOD_INDEX) && w->labels == 0)
+            weights[method] = 0;
+        total += weights[method];
+    }
+    if (total == 0) /* Every command accepts a register, except for the source of lea */
+        return accepts_method(opcode, is_dest, METHOD_REGISTER) ? METHOD_REGISTER : METHOD_DIRECT;
+
+    pick = random_below(total);
+    for (method = 0; pick >= weights[method]; method++)
+        pick -= weights[method];
+    return method;
+}
+
+/* This function writes a label that can be referred to: a label of a statement or an external label */
+static void write_label_reference(FILE *fp, const workload *w)
+{
+    long externs = w->labels * w->extern_percent / 100, i = random_below(w->labels + externs);
+
+    if (i < w->labels)
+        fprintf(fp, "L%ld", i);
+    else
+        fprintf(fp, "X%ld", i - w->labels);
+}
+
+/* This function writes a number or a constant (a constant only where it can be used instead of a number) */
+static void write_value(FILE *fp, const workload *w, long max)
+{
+    if (w->constants > 0 && random_percent(25))
+        fprintf(fp, "K%ld", random_below(w->constants));
+    else
+        fprintf(fp, "%ld", random_below(2 * max + 1) - max);
+}
+
+/* This function writes an operand with the given addressing method, and returns the number of its words */
+static int write_operand(FILE *fp, const workload *w, int method)
+{
+    switch (method) {
+        case METHOD_IMMEDIATE:
+            fputc('#', fp);
+            write_value(fp, w, 500);
+            return 1;
+        case METHOD_DIRECT:
+            write_label_reference(fp, w);
+            return 1;
+        case METHOD_INDEX: /* An array is a label of a statement, the index is a number or a constant */
+            fprintf(fp, "L%ld[", random_below(w->labels));
+            if (w->constants > 0 && random_percent(25))
+                fprintf(fp, "K%ld", random_below(w->constants));
+            else
+                fprintf(fp, "%ld", random_below(16));
+            fputc(']', fp);
+            return 2;
+        default:
+            fprintf(fp, "r%ld", random_below(8));
+            return 1;
+    }
+}
+
+/* This function writes a command with random operands that it accepts */
+static void write_command(FILE *fp, const workload *w)
+{
+    int opcode = (int) random_below(NUM_OPCODES), src, dest;
+
+    while (opcode == LEA && w->labels == 0) /* The source of lea must be a label */
+        opcode = (int) random_below(NUM_OPCODES);
+
+    fputs(opcode_names[opcode], fp);
+    words++;
+    switch (opcode) {
+        case MOV: case CMP: case ADD: case SUB: case LEA: /* 2 operands */
+            src = choose_method(w, opcode, FALSE);
+            dest = choose_method(w, opcode, TRUE);
+            fputc(' ', fp);
+            words += write_operand(fp, w, src);
+            fputs(", ", fp);
+            words += write_operand(fp, w, dest);
+            if (src == METHOD_REGISTER && dest == METHOD_REGISTER)
+                words--; /* 2 registers share a word */
+            break;
+        case RTS: case HLT: /* no operands */
+            break;
+        default: /* 1 operand */
+            fputc(' ', fp);
+            words += write_operand(fp, w, choose_method(w, opcode, TRUE));
+    }
+    fputc('\n', fp);
+}
+
+/* This function writes a .data or a .string directive */
+static void write_data(FILE *fp, const workload *w)
+{
+    long i, n;
+
+    if (random_percent(w->string_percent)) {
+        n = 1 + random_below(MAX_STRING_LENGTH);
+        fputs(".string \"", fp);
+        for (i = 0; i < n; i++)
+            fputc('a' + (int) random_below(26), fp);
+        fputs("\"\n", fp);
+        words += n + 1; /* The characters and a '\0' */
+        return;
+    }
+    n = 1 + random_below(MAX_DATA_NUMBERS);
+    fputs(".data ", fp);
+    for (i = 0; i < n; i++) {
+        if (i > 0)
+            fputs(", ", fp);
+        write_value(fp, w, 1000);
+    }
+    fputc('\n', fp);
+    words += n;
+}
+
+/* This function writes a statement: a command or a data directive, by the share of the data directives */
+static void write_statement(FILE *fp, const workload *w)
+{
+    if (random_percent(w->data_percent))
+        write_data(fp, w);
+    else
+        write_command(fp, w);
+}
+
+/* This function writes a whole program: the constants and the external labels, the macros, the statements (with
+ * the labels and the calls of the macros spread evenly between them) and the entries.
+ * It returns the number of words of the program's memory image, or -1 if there's not enough memory to count them. */
+static long write_program(FILE *fp, const workload *w)
+{
+    long externs = w->labels * w->extern_percent / 100, entries = w->labels * w->entry_percent / 100;
+    long i, j, next_label = 0, next_call = 0, *body_words;
+
+    body_words = (long *) malloc((w->macros + 1) * sizeof(long));
+    if (body_words == NULL)
+        return -1;
+
+    for (i = 0; i < w->constants; i++)
+        fprintf(fp, ".define K%ld = %ld\n", i, random_below(64));
+    for (i = 0; i < externs; i++)
+        fprintf(fp, ".extern X%ld\n", i);
+
+    for (i = 0; i < w->macros; i++) {
+        words = 0;
+        fprintf(fp, "mcr M%ld\n", i);
+        for (j = 0; j < w->body; j++) {
+            fputc(' ', fp);
+            write_statement(fp, w);
+        }
+        fputs("endmcr\n", fp);
+        body_words[i] = words; /* The words of a macro are in the memory once for every call */
+    }
+
+    words = 0;
+    for (i = 0; i <= w->lines; i++) {
+        while (next_call < w->calls && (i == w->lines || next_call * w->lines <= i * w->calls)) {
+            fprintf(fp, "M%ld\n", next_call % w->macros);
+            words += body_words[next_call++ % w->macros];
+        }
+        if (i == w->lines)
+            break;
+        if (next_label < w->labels && next_label * w->lines <= i * w->labels)
+            fprintf(fp, "L%ld: ", next_label++);
+        write_statement(fp, w);
+    }
+
+    for (i = 0; i < entries; i++)
+        fprintf(fp, ".entry L%ld\n", i * w->labels / entries);
+    free(body_words);
+    return words;
+}
+
+/* This function prints the usage of the generator */
+static void usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [-l LINES] [-s LABELS] [-c CONSTANTS] [-m MACROS] [-b BODY] [-k CALLS]\n"
+                    "       [-e EXTERN%%] [-n ENTRY%%] [-d DATA%%] [-t STRING%%] [-a IMM,DIR,IDX,REG] [-r SEED] [-o FILE]\n",
+            name);
+}
+
+/* This function generates a program by the parameters in the command line, to the standard output or to a file.
+ * It fails if the program wouldn't fit in the memory of the machine, since such a program isn't valid. */
+int main(int argc, char *argv[])
+{
+    workload w;
+    FILE *fp, *dest;
+    char *output = NULL, *value, buffer[BUFSIZ];
+    long *field, total;
+    size_t n;
+    int i, *percent;
+
+    w.lines = 200;
+    w.labels = -1; /* A quarter of the lines, unless it's given */
+    w.constants = 10;
+    w.macros = 4;
+    w.body = 4;
+    w.calls = -1; /* A call of every macro, unless it's given */
+    w.extern_percent = 20;
+    w.entry_percent = 20;
+    w.data_percent = 25;
+    w.string_percent = 30;
+    w.method_weights[METHOD_IMMEDIATE] = 3;
+    w.method_weights[METHOD_DIRECT] = 4;
+    w.method_weights[METHOD_INDEX] = 1;
+    w.method_weights[METHOD_REGISTER] = 4;
+    w.seed = 1;
+
+    for (i = 1; i < argc; i++) {
+        if (argv[i][0] != '-' || argv[i][1] == '\0' || argv[i][2] != '\0' || i + 1 == argc) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        value = argv[i + 1];
+        field = NULL;
+        percent = NULL;
+        switch (argv[i++][1]) {
+            case 'l': field = &w.lines; break;
+            case 's': field = &w.labels; break;
+            case 'c': field = &w.constants; break;
+            case 'm': field = &w.macros; break;
+            case 'b': field = &w.body; break;
+            case 'k': field = &w.calls; break;
+            case 'e': percent = &w.extern_percent; break;
+            case 'n': percent = &w.entry_percent; break;
+            case 'd': percent = &w.data_percent; break;
+            case 't': percent = &w.string_percent; break;
+            case 'r': w.seed = strtoul(value, NULL, 10); break;
+            case 'o': output = value; break;
+            case 'a':
+                if (sscanf(value, "%d,%d,%d,%d", &w.method_weights[0], &w.method_weights[1], &w.method_weights[2],
+                           &w.method_weights[3]) != NUM_METHODS) {
+                    usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            default:
+                usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+        if (field)
+            *field = atol(value);
+        if (percent)
+            *percent = atoi(value);
+    }
+    if (w.labels < 0)
+        w.labels = w.lines / 4;
+    if (w.calls < 0 || w.macros == 0)
+        w.calls = w.macros;
+    if (w.lines < 0 || w.labels > w.lines || w.constants < 0 || w.body < 0 || w.calls < 0) {
+        fprintf(stderr, "%s: the numbers can't be negative, and there can't be more labels than lines\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    /* The program is generated to a temporary file first, so nothing is written if it turns out to be too large */
+    random_state = w.seed;
+    fp = tmpfile();
+    if (fp == NULL || (total = write_program(fp, &w)) < 0) {
+        fprintf(stderr, "%s: can't generate the program\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (total > MEMORY_WORDS) {
+        fprintf(stderr, "%s: the program has %ld words, more than the memory (%d words)\n", argv[0], total,
+                MEMORY_WORDS);
+        fclose(fp);
+        return EXIT_FAILURE;
+    }
+
+    dest = output ? fopen(output, "w") : stdout;
+    if (dest == NULL) {
+        fprintf(stderr, "%s: can't open %s\n", argv[0], output);
+        fclose(fp);
+        return EXIT_FAILURE;
+    }
+    rewind(fp);
+    while ((n = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+        fwrite(buffer, 1, n, dest);
+    fclose(fp);
+    if (output)
+        fclose(dest);
+    return EXIT_SUCCESS;
+}
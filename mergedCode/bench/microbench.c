@@ -0,0 +1,290 @@
+/*=======================================================================================================
+Project: Maman 14 - Assembler
+Created by:
+Edrehy Tal and Liberman Ron Rafail
+
+Date: 18/04/2024
+Description: Microbenchmarks of the tokenizer and the validators of the first pass. Every function is run over
+a corpus that is taken from real programs (the preprocessed lines of the given source files, their tokens and the
+operands of their commands), and its time and heap allocations per call are reported.
+========================================================================================================= */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../utils.h"
+#include "../prototypes.h"
+#include "../PreProcessor.h"
+#include "../keywords.h"
+#include "../stats.h"
+
+#define MIN_SECONDS 0.2 /* every function is run over its corpus again and again for at least this time */
+
+/* An operand of a command, with the context of its program (the validators look up its labels) */
+typedef struct operand_sample {
+    span operand;
+    assembler_context *ctx;
+} operand_sample;
+
+/* A benchmark: a function that calls the measured function once for every item of its corpus */
+typedef struct benchmark {
+    const char *name; /* the measured function */
+    const char *corpus; /* what it's called on */
+    long (*run)(void); /* runs over the corpus once, returns the number of calls */
+} benchmark;
+
+/* The corpora, taken from the programs */
+static char **lines; /* the lines of the preprocessed sources (without blank lines and comments) */
+static int num_lines, lines_capacity;
+static span *tokens; /* the tokens of the lines, split by whitespace */
+static int num_tokens, tokens_capacity;
+static span *list_tokens; /* the tokens of the lines, split as lists (by whitespace and commas) */
+static int num_list_tokens, list_tokens_capacity;
+static operand_sample *operands; /* the operands of the commands */
+static int num_operands, operands_capacity;
+
+static assembler_context *first_ctx; /* the context of the first program (for the validators that report errors) */
+static volatile long sink; /* the results of the functions are added here, so the calls aren't optimized away */
+
+/* This function makes room for one more element in a corpus, and ends the benchmark if there's not enough memory */
+static void reserve(void **array, int length, int *capacity, size_t element_size)
+{
+    if (!ensure_capacity(array, length, capacity, element_size)) {
+        fprintf(stderr, "microbench: not enough memory for the corpora\n");
+        exit(1);
+    }
+}
+
+/* This function adds a line of a program to the corpora: the line, its tokens, and the operands of its command
+ * (if it's a command, after an optional label) */
+static void add_line(assembler_context *ctx, char *line)
+{
+    span token, first, second;
+    char *ptr;
+
+    reserve((void **) &lines, num_lines, &lines_capacity, sizeof(char *));
+    lines[num_lines++] = line;
+
+    for (ptr = skip_spaces(line); !end_of_line(ptr); ptr = skip_spaces(ptr)) {
+        ptr = extract_token(&token, ptr);
+        reserve((void **) &tokens, num_tokens, &tokens_capacity, sizeof(span));
+        tokens[num_tokens++] = token;
+    }
+    for (ptr = next_list_token(&token, line); token.kind != TOKEN_END; ptr = next_list_token(&token, ptr)) {
+        reserve((void **) &list_tokens, num_list_tokens, &list_tokens_capacity, sizeof(span));
+        list_tokens[num_list_tokens++] = token;
+    }
+
+    ptr = extract_token(&token, skip_spaces(line));
+    if (token.len > 0 && token.start[token.len - 1] == ':')
+        ptr = extract_token(&token, skip_spaces(ptr));
+    if (token.kind == TOKEN_END || classify_keyword(token.start, token.len).kind != KEYWORD_COMMAND)
+        return;
+    ptr = next_list_token(&first, ptr);
+    if (first.kind != TOKEN_WORD)
+        return;
+    ptr = next_list_token(&second, ptr);
+    if (second.kind == TOKEN_COMMA)
+        next_list_token(&second, ptr);
+    reserve((void **) &operands, num_operands, &operands_capacity, sizeof(operand_sample));
+    operands[num_operands].operand = first;
+    operands[num_operands++].ctx = ctx;
+    if (second.kind == TOKEN_WORD) {
+        reserve((void **) &operands, num_operands, &operands_capacity, sizeof(operand_sample));
+        operands[num_operands].operand = second;
+        operands[num_operands++].ctx = ctx;
+    }
+}
+
+/* This function preprocesses a program and passes over it with the first pass (so its symbols table is complete),
+ * and adds its lines to the corpora. The context is kept until the end of the run.
+ * Returns FALSE if the program couldn't be read or has errors. */
+static boolean load_program(char *name, FILE *null_stream)
+{
+    assembler_context *ctx;
+    file_context *src;
+    status_error_code report;
+    char *text, *line, *end, *eol;
+    size_t len = strlen(name);
+
+    if (len > FILE_EXT_LEN && strcmp(name + len - FILE_EXT_LEN, ASSEMBLY_EXT) == 0)
+        name[len - FILE_EXT_LEN] = '\0'; /* The name is given with or without its extension */
+
+    ctx = create_assembler_context(null_stream, null_stream);
+    if (ctx == NULL)
+        return FALSE;
+    src = create_file_context(ctx, name, ASSEMBLY_EXT, FILE_EXT_LEN, FILE_MODE_READ, &report);
+    if (src == NULL || assembler_preprocessor(ctx, src) != NO_ERROR || ctx->source.text == NULL) {
+        free_file_context(&src);
+        free_assembler_context(&ctx);
+        return FALSE;
+    }
+    free_file_context(&src);
+
+    /* The first pass terminates the lines of the source in place, so the corpora get their own copy */
+    text = (char *) malloc(ctx->source.len + 1);
+    if (text == NULL) {
+        free_assembler_context(&ctx);
+        return FALSE;
+    }
+    memcpy(text, ctx->source.text, ctx->source.len + 1);
+    end = text + ctx->source.len;
+    first_pass(ctx);
+    if (ctx->was_error) {
+        free(text);
+        free_assembler_context(&ctx);
+        return FALSE;
+    }
+
+    for (line = text; line < end; line = eol + 1) {
+        eol = (char *) memchr(line, '\n', end - line);
+        if (eol == NULL)
+            eol = end;
+        *eol = '\0';
+        if (!ignore(line))
+            add_line(ctx, line);
+    }
+    if (first_ctx == NULL)
+        first_ctx = ctx;
+    return TRUE;
+}
+
+/* The benchmarks. Each one calls its function once for every item of its corpus */
+
+static long run_skip_spaces(void)
+{
+    int i;
+    for (i = 0; i < num_lines; i++)
+        sink += skip_spaces(lines[i]) - lines[i];
+    return num_lines;
+}
+
+static long run_extract_token(void)
+{
+    span token;
+    int i;
+    for (i = 0; i < num_tokens; i++) {
+        extract_token(&token, tokens[i].start);
+        sink += token.len;
+    }
+    return num_tokens;
+}
+
+static long run_next_list_token(void)
+{
+    span token;
+    char *ptr;
+    long calls = 0;
+    int i;
+    for (i = 0; i < num_lines; i++) { /* Splitting every line to its list tokens, a call for every token */
+        for (ptr = next_list_token(&token, lines[i]); token.kind != TOKEN_END; ptr = next_list_token(&token, ptr))
+            calls++;
+        calls++; /* The last call, that found the end of the line */
+    }
+    sink += calls;
+    return calls;
+}
+
+static long run_is_label(void)
+{
+    int i;
+    for (i = 0; i < num_tokens; i++) /* A token that ends with ':' is checked as the definition of a label */
+        sink += is_label(first_ctx, tokens[i], tokens[i].start[tokens[i].len - 1] == ':' ? COLON : NO_COLON);
+    first_ctx->err = NO_ERROR;
+    return num_tokens;
+}
+
+static long run_is_number(void)
+{
+    int i;
+    for (i = 0; i < num_list_tokens; i++)
+        sink += is_number(list_tokens[i]);
+    return num_list_tokens;
+}
+
+static long run_detect_method(void)
+{
+    int i;
+    for (i = 0; i < num_operands; i++) {
+        sink += detect_method(operands[i].ctx, operands[i].operand);
+        operands[i].ctx->err = NO_ERROR;
+    }
+    return num_operands;
+}
+
+static long run_classify_keyword(void)
+{
+    int i;
+    for (i = 0; i < num_tokens; i++)
+        sink += classify_keyword(tokens[i].start, tokens[i].len).kind;
+    return num_tokens;
+}
+
+static const benchmark benchmarks[] = {
+    {"skip_spaces", "lines", run_skip_spaces},
+    {"extract_token", "tokens", run_extract_token},
+    {"next_list_token", "lines (every token)", run_next_list_token},
+    {"is_label", "tokens", run_is_label},
+    {"is_number", "list tokens", run_is_number},
+    {"detect_method", "operands", run_detect_method},
+    {"classify_keyword", "tokens", run_classify_keyword}
+};
+
+/* This function runs a benchmark over its corpus until it took at least MIN_SECONDS, and prints its time and
+ * allocations per call */
+static void measure(const benchmark *b, assembler_stats *stats)
+{
+    double start, elapsed;
+    unsigned long allocations = stats->allocations;
+    long calls = 0;
+
+    b->run(); /* Warming up the caches */
+    allocations = stats->allocations;
+    start = wall_time();
+    do {
+        calls += b->run();
+        elapsed = wall_time() - start;
+    } while (elapsed < MIN_SECONDS && calls > 0);
+
+    printf("%-18s %-22s %12ld %10.2f %10.3f\n", b->name, b->corpus, calls, calls ? elapsed * 1e9 / calls : 0.0,
+           calls ? (double) (stats->allocations - allocations) / calls : 0.0);
+}
+
+/* This function loads the programs in the command line and runs all the benchmarks (or only the ones whose names are
+ * given with -f) */
+int main(int argc, char *argv[])
+{
+    FILE *null_stream = fopen("/dev/null", "w");
+    assembler_stats stats;
+    const char *only = NULL;
+    int i, programs = 0;
+
+    if (null_stream == NULL)
+        null_stream = stderr;
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+            only = argv[++i];
+        else if (load_program(argv[i], null_stream))
+            programs++;
+        else
+            fprintf(stderr, "%s: skipping %s (it can't be read or has errors)\n", argv[0], argv[i]);
+    }
+    if (programs == 0) {
+        fprintf(stderr, "Usage: %s [-f FUNCTION] file1.as file2.as ...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    printf("corpus: %d program(s), %d lines, %d tokens, %d list tokens, %d operands\n\n", programs, num_lines,
+           num_tokens, num_list_tokens, num_operands);
+    printf("%-18s %-22s %12s %10s %10s\n", "function", "corpus", "calls", "ns/op", "allocs/op");
+
+    init_stats(&stats, FALSE);
+    enable_allocation_counting();
+    bind_stats(&stats); /* The allocations of the benchmarks are counted in stats */
+    for (i = 0; i < (int) (sizeof(benchmarks) / sizeof(benchmarks[0])); i++)
+        if (only == NULL || strcmp(only, benchmarks[i].name) == 0)
+            measure(&benchmarks[i], &stats);
+    bind_stats(NULL);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,39 @@
+#!/bin/sh
+# Project: Maman 14 - Assembler
+# Assembles a scaled series of generated programs and writes the times and the counters of every run (--stats=csv)
+# to a CSV file, with the scale and the number of the run in the first columns.
+# It's run from the directory of the makefile by "make bench".
+#
+# Usage: bench/run_bench.sh [ASSEMBLER] [GENERATOR] [CSV]
+# SCALES (default "1 2 4 8 16") and REPEAT (default 5) can be set in the environment.
+# At scale K a program has 64*K statements, 16*K labels, 256*K constants and 8*K macros, so the largest one is close
+# to the memory of the machine.
+
+ASSEMBLER=${1:-./assembler}
+GENERATOR=${2:-bench/gen_workload}
+CSV=${3:-bench/results.csv}
+SCALES=${SCALES:-"1 2 4 8 16"}
+REPEAT=${REPEAT:-5}
+WORK=bench/work
+
+mkdir -p "$WORK" || exit 1
+rm -f "$CSV"
+
+for scale in $SCALES; do
+    program="$WORK/scale$scale"
+    "$GENERATOR" -l $((64 * scale)) -c $((256 * scale)) -m $((8 * scale)) -b 4 -k $((2 * scale)) -r 1 \
+        -o "$program.as" || exit 1
+
+    run=1
+    while [ "$run" -le "$REPEAT" ]; do
+        "$ASSEMBLER" -q --stats=csv "$program" > "$WORK/stats.csv" || { echo "bench: $program failed" >&2; exit 1; }
+        if [ ! -f "$CSV" ]; then
+            printf 'scale,run,' > "$CSV"
+            head -n 1 "$WORK/stats.csv" >> "$CSV"
+        fi
+        tail -n +2 "$WORK/stats.csv" | sed "s/^/$scale,$run,/" >> "$CSV"
+        run=$((run + 1))
+    done
+done
+rm -f "$WORK/stats.csv"
+echo "bench: wrote $CSV"
@@ -0,0 +1,105 @@
+#!/bin/sh
+# Project: Maman 14 - Assembler
+# The regression suite of the outputs and of the performance of the assembler. It's run from the directory of the
+# makefile by "make check", and fails (exit status 1) if either part fails:
+# 1. Every program of "input+output example/valid_input" is assembled, and its outputs (.am, .ob, .ent and .ext)
+#    are compared byte by byte with the expected ones. An output that isn't expected is a failure as well.
+#    Every program of "input+output example/errors" that has expected error messages (a .err file) is assembled,
+#    and the messages it writes are compared with them. Both are checked again with --stream, which must write the same.
+# 2. The same programs and a scaled series of generated ones are assembled REPEAT times, and the best time of every
+#    program is compared with the baseline. The throughput is the source lines of all the programs per millisecond,
+#    and it mustn't drop by more than THRESHOLD percents.
+# The baseline depends on the machine, so it isn't a part of the sources: the first run records it (and so does a
+# run with UPDATE_BASELINE=1, after a change that is expected to change the performance).
+#
+# Usage: bench/run_regression.sh [ASSEMBLER] [GENERATOR]
+# THRESHOLD (default 10), REPEAT (default 5), SCALES (default "1 4 16") and BASELINE (default bench/baseline.csv)
+# can be set in the environment.
+
+ASSEMBLER=${1:-./assembler}
+GENERATOR=${2:-bench/gen_workload}
+THRESHOLD=${THRESHOLD:-10}
+REPEAT=${REPEAT:-5}
+SCALES=${SCALES:-"1 4 16"}
+BASELINE=${BASELINE:-bench/baseline.csv}
+EXPECTED="input+output example/valid_input"
+ERRORS="input+output example/errors"
+WORK=bench/regress
+
+case "$ASSEMBLER" in /*) ;; *) ASSEMBLER="$(pwd)/$ASSEMBLER" ;; esac
+rm -rf "$WORK" && mkdir -p "$WORK" || exit 1
+failed=0
+
+# 1. The outputs of the examples, without and with --stream (which mustn't change what is written)
+programs=""
+for mode in "" --stream; do
+    out="$WORK${mode:+/stream}"
+    mkdir -p "$out" && cp "$EXPECTED"/*.as "$out"/ || exit 1
+    for source in "$out"/*.as; do
+        [ -z "$mode" ] && programs="$programs ${source%.as}"
+        # shellcheck disable=SC2086 (the mode is a single option, or none)
+        (cd "$out" && "$ASSEMBLER" -q $mode --keep-am "$(basename "${source%.as}")" > /dev/null 2>&1)
+    done
+    for expected in "$EXPECTED"/*.am "$EXPECTED"/*.ob "$EXPECTED"/*.ent "$EXPECTED"/*.ext; do
+        output="$out/$(basename "$expected")"
+        if [ ! -f "$output" ]; then
+            echo "FAIL: $output wasn't written"
+            failed=1
+        elif ! cmp -s "$expected" "$output"; then
+            echo "FAIL: $output differs from the expected output"
+            failed=1
+        fi
+    done
+    for output in "$out"/*.am "$out"/*.ob "$out"/*.ent "$out"/*.ext; do
+        if [ -f "$output" ] && [ ! -f "$EXPECTED/$(basename "$output")" ]; then
+            echo "FAIL: $output isn't expected"
+            failed=1
+        fi
+    done
+    mkdir -p "$out/errors" && cp "$ERRORS"/*.as "$out/errors"/ || exit 1
+    for expected in "$ERRORS"/*.err; do
+        name=$(basename "${expected%.err}")
+        # shellcheck disable=SC2086
+        (cd "$out/errors" && "$ASSEMBLER" -q $mode "$name" > /dev/null 2> "$name.err")
+        if ! cmp -s "$expected" "$out/errors/$name.err"; then
+            echo "FAIL: the error messages of $name.as${mode:+ ($mode)} differ from the expected ones"
+            failed=1
+        fi
+    done
+done
+[ "$failed" -eq 0 ] && echo "outputs: all the outputs of the examples are as expected"
+
+# 2. The performance of the examples and of the generated programs
+for scale in $SCALES; do
+    "$GENERATOR" -l $((64 * scale)) -c $((256 * scale)) -m $((8 * scale)) -b 4 -k $((2 * scale)) -r 1 \
+        -o "$WORK/scale$scale.as" || exit 1
+    programs="$programs $WORK/scale$scale"
+done
+run=1
+while [ "$run" -le "$REPEAT" ]; do
+    # shellcheck disable=SC2086 (the names of the programs don't have spaces)
+    "$ASSEMBLER" -q --stats=csv $programs 2> /dev/null | tail -n +2 >> "$WORK/runs.csv"
+    run=$((run + 1))
+done
+
+# The best time of every program (the sum of its phases), and the comparison of the throughput with the baseline
+awk -F, '{ ms = $2 + $4 + $6 + $8; if (!($1 in best) || ms < best[$1]) best[$1] = ms; lines[$1] = $10 }
+         END { for (f in best) printf "%s,%d,%.3f\n", f, lines[f], best[f] }' "$WORK/runs.csv" | sort > "$WORK/best.csv"
+
+if [ ! -f "$BASELINE" ] || [ -n "$UPDATE_BASELINE" ]; then
+    { echo "file,lines,best_wall_ms"; cat "$WORK/best.csv"; } > "$BASELINE"
+    echo "performance: recorded the baseline in $BASELINE"
+else
+    awk -F, -v threshold="$THRESHOLD" '
+        NR == FNR { if (FNR > 1) base[$1] = $3; next }
+        { lines += $2; ms += $3; if ($1 in base) { base_lines += $2; base_ms += base[$1] } }
+        END {
+            if (ms <= 0 || base_ms <= 0) { print "performance: nothing to compare with the baseline"; exit 0 }
+            now = lines / ms; before = base_lines / base_ms
+            change = (now - before) * 100 / before
+            printf "performance: %.1f lines/ms, baseline %.1f lines/ms (%+.1f%%, threshold -%s%%)\n", now, before, change, threshold
+            if (change < -threshold) { print "FAIL: the throughput dropped more than the threshold"; exit 1 }
+        }' "$BASELINE" "$WORK/best.csv" || failed=1
+fi
+
+exit $failed
@@ -10,12 +10,4 @@ Date: 18/04/2024
 #include "assembler.h"
 
 /*--------------------------------------Global Variables --------------------------------------------------*/
-extern int ic, dc; /*ic-instruction counter ; dc-data counter*/
-extern int err;
-extern boolean was_error;  /*flag to error exists*/
-extern labelPtr symbols_table; /*list of external labels*/
-extern extPtr ext_list;
-extern const char base4[4]; /*Speical 3 bits encripted*/
-extern const char *commands[]; /*list of our Assembly commands*/
-extern const char *directives[]; /*list of our directive sentences*/
-extern boolean entry_exists, extern_exists;/*flags to exists enrty and extern*/
+/* None: the state of each assembled file is kept in its assembler_context, the keywords are in keywords.c */
@@ -15,105 +15,179 @@ Date: 18/04/2024
 #include "extern_variables.h"
 #include "prototypes.h"
 #include "utils.h"
-
-/* This function manages all the activities of the first pass */
-void first_pass(FILE *fp)
+#include "line_source.h"
+#include "keywords.h"
+#include "log.h"
+#include "stats.h"
+
+/* This function manages all the activities of the first pass.
+ * The lines are read in place from the preprocessed source that the preprocessor left in the context. */
+void first_pass(assembler_context *ctx)
 {
-    char line[LINE_LENGTH]; /* This string will contain each line at a time */
-    int line_num = 1; /* Line numbers start from 1 */
+    line_source lines; /* The lines of the preprocessed source */
+    char *line;
+
+    start_first_pass(ctx);
+    if(index_line_source(&lines, ctx->source.text, ctx->source.len) != NO_ERROR)
+    {
+        handle_preprocessor_error(ctx, ERR_MEM_ALLOC);
+        ctx->was_error = TRUE; /* None of the lines was passed over, so the file can't be assembled */
+    }
+    while((line = next_line(&lines)) != NULL)
+        first_pass_line(ctx, line);
+    close_line_source(&lines);
+    end_first_pass(ctx);
+}
 
+/* This function initializes the context before the first line of the first pass */
+void start_first_pass(assembler_context *ctx)
+{
     /* Initializing data and instructions counter */
-    ic = 0;
-    dc = 0;
+    ctx->ic = 0;
+    ctx->dc = 0;
+    ctx->line_num = 0;
+}
 
-    while(fgets(line, LINE_LENGTH, fp) != NULL) /* Read lines until end of file */
+/* This function passes over a single line of the preprocessed source, and outputs its error (if there's one).
+ * The line whose words don't fit in the memory anymore is an error (the lines after it are still analyzed) */
+void first_pass_line(assembler_context *ctx, char *line)
+{
+    boolean was_full = ctx->ic + ctx->dc > MEMORY_WORDS;
+
+    ctx->line_num++; /* Line numbers start from 1 */
+    ctx->err = NO_ERROR; /* Reset the error of the context before parsing each line */
+    if(!ignore(line)) /* Ignore line if it's blank or ; */
+        analyze_line(ctx, line);
+    if(!is_error(ctx) && !was_full && ctx->ic + ctx->dc > MEMORY_WORDS)
+        ctx->err = MEMORY_OVERFLOW;
+    if(is_error(ctx)) {
+        ctx->was_error = TRUE; /* There was at least one error through all the program */
+        write_preprocessor_error(ctx, ctx->line_num); /* Output the error */
+    }
+}
+
+/* This function passes over the lines that the preprocessor completed so far, when the preprocessed source is streamed
+ * to the first pass (--stream). The lines are removed from the source, so it only holds the part of a line that isn't
+ * complete yet (after a macro's body ends a line, the rest of its line may still follow), and they are written to
+ * the .am file if it's kept. After the last line of the file, even a line that doesn't end with '\n' is complete.
+ * Their errors are written to the held errors of the context, if it holds them. */
+void stream_first_pass(assembler_context *ctx, boolean last)
+{
+    char *line = ctx->source.text, *end = ctx->source.text + ctx->source.len, *eol;
+    FILE *err_stream = ctx->err_stream;
+
+    if(line == NULL)
+        return; /* Nothing was preprocessed yet */
+    enter_phase(ctx, PHASE_FIRST_PASS); /* The time of the lines is the first pass's, not the preprocessor's */
+    if(ctx->pass_errors)
+        ctx->err_stream = ctx->pass_errors; /* The errors are written only if the whole file is preprocessed */
+    while(line < end)
     {
-        err = NO_ERROR; /* Reset the error global var before parsing each line */
-        if(!ignore(line)) /* Ignore line if it's blank or ; */
-            analyze_line(line);
-        if(is_error()) {
-            was_error = TRUE; /* There was at least one error through all the program */
-            write_preprocessor_error(line_num); /* Output the error */
-        }
-        line_num++;
+        eol = (char *) memchr(line, '\n', end - line);
+        if(eol == NULL && !last)
+            break; /* The line isn't complete yet */
+        if(eol == NULL)
+            eol = end;
+        if(ctx->am_stream)
+            fwrite(line, 1, eol - line + (eol < end), ctx->am_stream);
+        *eol = '\0';
+        first_pass_line(ctx, line);
+        line = eol + 1;
     }
-    
+    ctx->err_stream = err_stream;
+    if(line > end)
+        line = end;
+
+    /* Keeping only the rest of the line that isn't complete */
+    ctx->source.len = end - line;
+    memmove(ctx->source.text, line, ctx->source.len);
+    ctx->source.text[ctx->source.len] = '\0';
+    enter_phase(ctx, PHASE_PREPROCESS);
+}
+
+/* This function completes the first pass after its last line */
+void end_first_pass(assembler_context *ctx)
+{
     /* When the first pass ends and the symbols table is complete and IC is evaluated,
-       we can calculate real final addresses */
-    offset_addresses(symbols_table, MEMORY_START, FALSE); /* Instruction symbols will have addresses that start from 100 (MEMORY_START) */
-    offset_addresses(symbols_table, ic + MEMORY_START, TRUE); /* Data symbols will have addresses that start fron NENORY_START + IC */
+       we can place the segments (the final addresses are calculated when they're read) */
+    set_segment_base(&ctx->symbols_table, SYMBOL_CODE, MEMORY_START); /* Instruction symbols will have addresses that start from 100 (MEMORY_START) */
+    set_segment_base(&ctx->symbols_table, SYMBOL_DATA, ctx->ic + MEMORY_START); /* Data symbols will have addresses that start fron NENORY_START + IC */
 }
 
 /* This function will analyze a given line from the file and will extract the information*/
-void analyze_line(char *line)
+void analyze_line(assembler_context *ctx, char *line)
 {
     /* Initializing variables for the type of the directive/command */
     int dir_type = UNKNOWN_TYPE;
     int command_type = UNKNOWN_COMMAND;
 
     boolean label = FALSE; /* This variable will hold TRUE if a label exists in this line */
-    labelPtr label_node = NULL; /* This variable holds optional label in case we create it */
-    char current_token[LINE_LENGTH]; /* This string will hold the current token if we analyze it */
+    int label_node = NO_SYMBOL; /* This variable holds optional label in case we create it */
+    span current_token; /* This span of the line will hold the current token if we analyze it */
+    keyword token_keyword; /* The kind of the current token (directive, command or neither) */
     
     line = skip_spaces(line); /* skips to the next non-blank/whitepsace character */
     if(end_of_line(line)) return; /* a blank line is not an error */
     if(!isalpha(*line) && *line != '.') { /* first non-blank character must be a letter or a dot */
-        err = SYNTAX_ERR;
+        ctx->err = SYNTAX_ERR;
         return;
     }
 
-    extract_token(current_token, line); /* Assuming that label is separated from other tokens by a whitespace */
-    if(is_label(current_token, COLON)) { /* We check if the first token is a label (and it should contain a colon) */
+    extract_token(&current_token, line); /* Assuming that label is separated from other tokens by a whitespace */
+    if(is_label(ctx, current_token, COLON)) { /* We check if the first token is a label (and it should contain a colon) */
         label = TRUE;
-        label_node = add_label(&symbols_table, current_token, 0,"code",FALSE,FALSE); /* adding label to the global symbols table */
-        if(label_node == NULL){
-             printf("Error: creating label failed\n");
+        /* adding label (without its colon) to the symbols table */
+        label_node = add_label(ctx, current_token.start, current_token.len - 1, 0, SYMBOL_DATA);
+        if(label_node == NO_SYMBOL){
+             log_message(ctx, LOG_VERBOSE, "Error: creating label failed\n");
              return;
         } /* There was an error creating label */
            
         line = next_token(line); /* Skipping to beginning of next token */
         if(end_of_line(line))
         {
-            err = LABEL_ONLY; /* A line can't be label-only */
+            ctx->err = LABEL_ONLY; /* A line can't be label-only */
             return;
         }
-        extract_token(current_token, line); /* Proceed to next token */
+        extract_token(&current_token, line); /* Proceed to next token */
     } /* If there's a label error then exit this function */
 
-    if(is_error()) /* is_label might return an error */
+    if(is_error(ctx)) /* is_label might return an error */
         return;
 
-    if((dir_type = find_directive(current_token)) != NOT_FOUND) /* detecting directive type (if it's a directive) */
+    token_keyword = classify_keyword(current_token.start, current_token.len);
+    if(token_keyword.kind == KEYWORD_DIRECTIVE) /* detecting directive type (if it's a directive) */
     {
+        dir_type = token_keyword.value;
         if(label)
         {
             if(dir_type == EXTERN || dir_type == ENTRY) { /* ignore creation of label before .entry/.extern */
-                delete_label(&symbols_table, label_node->name);
+                delete_label(&ctx->symbols_table, label_node);
                 label = FALSE;
             }
             else{
-                label_node -> address = dc; /* Address of data label is dc */
+                define_label(&ctx->symbols_table, label_node, ctx->dc, SYMBOL_DATA); /* Address of data label is dc */
             }
         }
         line = next_token(line);
-        handle_directive(dir_type, line);
+        handle_directive(ctx, dir_type, line);
     }
 
-    else if ((command_type = find_command(current_token)) != NOT_FOUND) /* detecting command type (if it's a command) */
+    else if (token_keyword.kind == KEYWORD_COMMAND) /* detecting command type (if it's a command) */
     {
+        command_type = token_keyword.value;
         if(label)
         {
             /* Setting fields accordingly in label */
-            label_node -> inActionStatement = TRUE; 
-            label_node -> address = ic;
+            define_label(&ctx->symbols_table, label_node, ctx->ic, SYMBOL_CODE);
         }
         line = next_token(line);
-        handle_command(command_type, line);
+        handle_command(ctx, command_type, line);
     }
 
     else
     {
-        err = COMMAND_NOT_FOUND; /* a line must have a directive/command */
+        ctx->err = COMMAND_NOT_FOUND; /* a line must have a directive/command */
     }
 
 }
@@ -121,11 +195,13 @@ void analyze_line(char *line)
 /* This function handles all kinds of directives (.data, .string, .entry, .extern)
  * and sends them accordingly to the suitable function for analyzing them
  * */
-int handle_directive(int type, char *line)
+int handle_directive(assembler_context *ctx, int type, char *line)
 {
+    span token; /* This will hold the label of an .entry directive */
+
     if(line == NULL || end_of_line(line)) /* All directives must have at least one parameter */
     {
-        err = DIRECTIVE_NO_PARAMS;
+        ctx->err = DIRECTIVE_NO_PARAMS;
         return ERROR;
     }
 
@@ -133,27 +209,39 @@ int handle_directive(int type, char *line)
     {
         case DATA:
             /* Handle .data directive and insert values separated by comma to the memory */
-            return handle_data_directive(line);
+            return handle_data_directive(ctx, line);
 
         case STRING:
             /* Handle .string directive and insert all characters (including a '\0') to memory */
-            return handle_string_directive(line);
+            return handle_string_directive(ctx, line);
 
         case ENTRY:
-            /* Only check for syntax of entry (should not contain more than one parameter) */
+            /* Check for syntax of entry (should not contain more than one parameter) */
             if(!end_of_line(next_token(line))) /* If there's a next token (after the first one) */
             {
-                err = DIRECTIVE_INVALID_NUM_PARAMS;
+                ctx->err = DIRECTIVE_INVALID_NUM_PARAMS;
                 return ERROR;
             }
+            /* The label might be defined later, so the entry is made in the second pass */
+            extract_token(&token, line);
+            if(!ensure_capacity((void **) &ctx->entries, ctx->entries_len, &ctx->entries_capacity, sizeof(entry_ref)))
+            {
+                ctx->err = OUT_OF_MEMORY;
+                return ERROR;
+            }
+            ctx->entries[ctx->entries_len].symbol = add_name(ctx, token.start, token.len);
+            if(ctx->entries[ctx->entries_len].symbol == NO_NAME) /* The error is already in the context */
+                return ERROR;
+            ctx->entries[ctx->entries_len].line = ctx->line_num;
+            ctx->entries_len++;
             break;
 
         case EXTERN:
             /* Handle .extern directive */
-            return handle_extern_directive(line);
+            return handle_extern_directive(ctx, line);
         case DEFINE:
             /*Handle .define directive*/
-            return handle_define_directive(line);
+            return handle_define_directive(ctx, line);
     }
     return NO_ERROR;
 }
@@ -161,35 +249,36 @@ int handle_directive(int type, char *line)
 /* This function analyzes a command, given the type (mov/jmp/etc...) and the sequence of
  characters starting after the command.
 
- It will detect the addressing methods of the operands and will encode the first word of
-  the command to the instructions memory. */
-int handle_command(int type, char *line)
+ It will detect the addressing methods of the operands and will add the decoded command to the
+  context's decoded commands (which are encoded in the second pass), and increase ic by its number of words. */
+int handle_command(assembler_context *ctx, int type, char *line)
 {
     boolean is_first = FALSE, is_second = FALSE; /* These booleans will tell which of the operands were
                                                      received (not by source/dest, but by order) */
     int first_method, second_method; /* These will hold the addressing methods of the operands */
-    char first_op[MAX_OP_LENGTH], second_op[MAX_OP_LENGTH]; /* These strings will hold the operands */
+    span first_op, second_op; /* These spans of the line will hold the operands */
+    decoded_instruction *instruction; /* This will hold the decoded command */
 
     /* Trying to parse 2 operands */
-    line = next_list_token(first_op, line);
-    if(!end_of_line(first_op)) /* If first operand is not empty */
+    line = next_list_token(&first_op, line);
+    if(first_op.kind != TOKEN_END) /* If first operand is not empty */
     {
         is_first = TRUE; /* First operand exists! */
-        line = next_list_token(second_op, line);
-        if(!end_of_line(second_op)) /* If second operand (should hold temporarily a comma) is not empty */
+        line = next_list_token(&second_op, line);
+        if(second_op.kind != TOKEN_END) /* If second operand (should hold temporarily a comma) is not empty */
         {
-            if(second_op[0] != ',') /* A comma must separate two operands of a command */
+            if(second_op.kind != TOKEN_COMMA) /* A comma must separate two operands of a command */
             {
-                err = COMMAND_UNEXPECTED_CHAR;
+                ctx->err = COMMAND_UNEXPECTED_CHAR;
                 return ERROR;
             }
 
             else
             {
-                line = next_list_token(second_op, line); 
-                if(end_of_line(second_op)) /* If second operand is not empty */
+                line = next_list_token(&second_op, line); 
+                if(second_op.kind == TOKEN_END) /* If second operand is not empty */
                 {
-                    err = COMMAND_UNEXPECTED_CHAR;
+                    ctx->err = COMMAND_UNEXPECTED_CHAR;
                     return ERROR;
                 }
                 is_second = TRUE; /* Second operand exists! */
@@ -199,35 +288,51 @@ int handle_command(int type, char *line)
     line = skip_spaces(line);
     if(!end_of_line(line)) /* If the line continues after two operands */
     {
-        err = COMMAND_TOO_MANY_OPERANDS;
+        ctx->err = COMMAND_TOO_MANY_OPERANDS;
         return ERROR;
     }
 
     if(is_first)
-        first_method = detect_method(first_op); /* Detect addressing method of first operand */
+        first_method = detect_method(ctx, first_op); /* Detect addressing method of first operand */
     if(is_second)
-        second_method = detect_method(second_op); /* Detect addressing method of second operand */
+        second_method = detect_method(ctx, second_op); /* Detect addressing method of second operand */
 
-    if(!is_error()) /* If there was no error while trying to parse addressing methods */
+    if(!is_error(ctx)) /* If there was no error while trying to parse addressing methods */
     {
         if(command_accept_num_operands(type, is_first, is_second)) /* If number of operands is valid for this specific command */
         {
             if(command_accept_methods(type, first_method, second_method)) /* If addressing methods are valid for this specific command */
             {
-                /* encode first word of the command to memory and increase ic by the number of additional words */
-                encode_to_instructions(build_first_word(type, is_first, is_second, first_method, second_method));
-                ic += calculate_command_num_additional_words(is_first, is_second, first_method, second_method);
+                /* add the decoded command and increase ic by its first word and the number of additional words */
+                if(!ensure_capacity((void **) &ctx->code, ctx->code_len, &ctx->code_capacity, sizeof(decoded_instruction)))
+                {
+                    ctx->err = OUT_OF_MEMORY;
+                    return ERROR;
+                }
+                instruction = &ctx->code[ctx->code_len++];
+                instruction->opcode = type;
+                instruction->line = ctx->line_num;
+                decode_operand(ctx, make_span(NULL, 0), METHOD_UNKNOWN, &instruction->src);
+                decode_operand(ctx, make_span(NULL, 0), METHOD_UNKNOWN, &instruction->dest);
+                if(is_second) /* There are 2 operands */
+                {
+                    decode_operand(ctx, first_op, first_method, &instruction->src);
+                    decode_operand(ctx, second_op, second_method, &instruction->dest);
+                }
+                else if(is_first) /* If there's only one operand, it's a destination operand */
+                    decode_operand(ctx, first_op, first_method, &instruction->dest);
+                ctx->ic += 1 + calculate_command_num_additional_words(is_first, is_second, first_method, second_method);
             }
 
             else
             {
-                err = COMMAND_INVALID_OPERANDS_METHODS;
+                ctx->err = COMMAND_INVALID_OPERANDS_METHODS;
                 return ERROR;
             }
         }
         else
         {
-            err = COMMAND_INVALID_NUMBER_OF_OPERANDS;
+            ctx->err = COMMAND_INVALID_NUMBER_OF_OPERANDS;
             return ERROR;
         }
     }
@@ -237,25 +342,22 @@ int handle_command(int type, char *line)
 
 
 /* This function handles a .string directive by analyzing it and encoding it to data */
-int handle_string_directive(char *line)
+int handle_string_directive(assembler_context *ctx, char *line)
 {
-    char token[LINE_LENGTH];
+    span token;
 
-    /*line = next_list_token(token, line);
-    line = next_token(line);*/
-    line = next_token_string(token, line);
-    if(!end_of_line(token) && is_string(token)) { /* If token exists and it's a valid string */
+    line = next_token_string(&token, line);
+    if(token.kind != TOKEN_END && is_string(token)) { /* If token exists and it's a valid string */
         line = skip_spaces(line);
         if(end_of_line(line)) /* If there's no additional token */
         {
-            /* "Cutting" quotation marks and encoding it to data */
-            token[strlen(token) - 1] = '\0';
-            write_string_to_data(token + 1);
+            /* Encoding it to data without the quotation marks */
+            write_string_to_data(ctx, token.start + 1, token.len - 2);
         }
 
         else /* There's another token */
         {
-            err = STRING_TOO_MANY_OPERANDS;
+            ctx->err = STRING_TOO_MANY_OPERANDS;
             return ERROR;
         }
 
@@ -263,7 +365,7 @@ int handle_string_directive(char *line)
 
     else /* Invalid string */
     {
-        err = STRING_OPERAND_NOT_VALID;
+        ctx->err = STRING_OPERAND_NOT_VALID;
         return ERROR;
     }
 
@@ -273,10 +375,10 @@ int handle_string_directive(char *line)
 
 
 /* This function parses parameters of a data directive and encodes them to memory */
-int handle_data_directive(char *line)
+int handle_data_directive(assembler_context *ctx, char *line)
 {
-    char token[MAX_OP_LENGTH]; /* Holds tokens */
-    labelPtr data_const;
+    span token; /* Holds tokens */
+    int data_const;
     /* These booleans mark if there was a number or a comma before current token,
      * so that if there wasn't a number, then a number will be required and
      * if there was a number but not a comma, a comma will be required */
@@ -284,42 +386,42 @@ int handle_data_directive(char *line)
 
     while(!end_of_line(line))
     {
-        line = next_list_token(token, line); /* Getting current token */
+        line = next_list_token(&token, line); /* Getting current token */
 
-        if(strlen(token) > 0) /* Not an empty token */
+        if(token.kind != TOKEN_END) /* Not an empty token */
         {
             if (!valid_input) { /* if there wasn't a number before */
                 if (!is_number(token)) { /* then the token must be a number or a label*/
-                    if(!is_label(token,FALSE)){ /* if that not a label as well*/
-                        err = DATA_EXPECTED_NUM_OR_CONST;
+                    if(!is_label(ctx, token,FALSE)){ /* if that not a label as well*/
+                        ctx->err = DATA_EXPECTED_NUM_OR_CONST;
                         return ERROR;
                     }
                     else{ /*if its label extract the label and write to data*/
-                        data_const = get_label(symbols_table,token);
-                        if(data_const!=NULL){
+                        data_const = find_label(&ctx->symbols_table, token.start, token.len);
+                        if(data_const!=NO_SYMBOL){
                             valid_input = TRUE;
                             comma = FALSE;
-                            write_num_to_data(data_const->address);
+                            write_num_to_data(ctx, SYMBOL_VALUE(&ctx->symbols_table, data_const));
                         }
                     }
                 }
                 else {
                     valid_input = TRUE; /* A valid number or const was inputted */
                     comma = FALSE; /* Resetting comma (now it is needed) */
-                    write_num_to_data(atoi(token)); /* encoding number to data */
+                    write_num_to_data(ctx, atoi(token.start)); /* encoding number to data (it ends the digits) */
                 }
             }
 
-            else if (*token != ',') /* If there was a number, now a comma is needed */
+            else if (token.kind != TOKEN_COMMA) /* If there was a number, now a comma is needed */
             {
-                err = DATA_EXPECTED_COMMA_AFTER_NUM;
+                ctx->err = DATA_EXPECTED_COMMA_AFTER_NUM;
                 return ERROR;
             }
 
             else /* If there was a comma, it should be only once (comma should be false) */
             {
                 if(comma) {
-                    err = DATA_COMMAS_IN_A_ROW;
+                    ctx->err = DATA_COMMAS_IN_A_ROW;
                     return ERROR;
                 }
                 else {
@@ -332,80 +434,84 @@ int handle_data_directive(char *line)
     }
     if(comma == TRUE)
     {
-        err = DATA_UNEXPECTED_COMMA;
+        ctx->err = DATA_UNEXPECTED_COMMA;
         return ERROR;
     }
     return NO_ERROR;
 }
 
-/* This function encodes a given number to data */
-void write_num_to_data(int num)
+/* This function encodes a given number to data (past the end of the memory it's only counted) */
+void write_num_to_data(assembler_context *ctx, int num)
 {
-    data[dc++] = (unsigned int) num;
+    if(ctx->dc < MEMORY_WORDS)
+        ctx->data[ctx->dc] = (unsigned int) num;
+    ctx->dc++;
 }
 
-/* This function encodes a given string to data */
-void write_string_to_data(char *str)
+/* This function encodes a given string (its characters and their number) to data.
+ * The string was read as list tokens, so the whitespace between them isn't a part of it. */
+void write_string_to_data(assembler_context *ctx, char *str, int len)
 {
-    while(!end_of_line(str))
+    char *end = str + len;
+    while(str < end)
     {
-        data[dc++] = (unsigned int) *str; /* Inserting a character to data array */
+        if(!isspace(*str))
+            write_num_to_data(ctx, *str); /* Inserting a character to data array */
         str++;
     }
-    data[dc++] = '\0'; /* Insert a null character to data */
+    write_num_to_data(ctx, '\0'); /* Insert a null character to data */
 }
 
 /* This function tries to find the addressing method of a given operand and returns -1 if it was not found */
-int detect_method(char * operand)
+int detect_method(assembler_context *ctx, span operand)
 {
     char *open_bracket, *close_bracket;
-    char name_of_array_index[LABEL_LENGTH]; /* hold the name of the array*/
-    char wanted_index[MAX_INDEX_LENGTH]; /* the index number of the operand  */
-    labelPtr index_label;
+    span name_of_array_index; /* hold the name of the array*/
+    span wanted_index; /* the index number of the operand  */
+    int index_label;
 
-    if(end_of_line(operand)) return NOT_FOUND;
+    if(operand.len == 0) return NOT_FOUND;
 
     /*----- Immediate addressing method check -----*/
-    if (*operand == '#') { /* First character is '#' */
-        operand++;
+    if (*operand.start == '#') { /* First character is '#' */
+        operand = make_span(operand.start + 1, operand.len - 1);
         if (is_number(operand)){     
             return METHOD_IMMEDIATE;
         }
-        if(is_label(operand,FALSE)){
-            index_label = get_label(symbols_table,operand);
+        if(is_label(ctx, operand,FALSE)){
+            index_label = find_label(&ctx->symbols_table, operand.start, operand.len);
 
-            if(strcmp(index_label ->property,MDEFINE)==0){
+            if(index_label != NO_SYMBOL && SYMBOL_KIND(&ctx->symbols_table, index_label) == SYMBOL_CONSTANT){
                 return METHOD_IMMEDIATE;
             }
         }
     }
 
     /*----- Register addressing method check -----*/
-    else if (is_register(operand))
+    else if (classify_keyword(operand.start, operand.len).kind == KEYWORD_REGISTER)
         return METHOD_REGISTER;
 
     /*----- Direct addressing method check ----- */
-    else if (is_label(operand, FALSE)) /* Checking if it's a label when there shouldn't be a colon (:) at the end */
+    else if (is_label(ctx, operand, FALSE)) /* Checking if it's a label when there shouldn't be a colon (:) at the end */
         return METHOD_DIRECT;
 
     /*----- index addressing method check -----*/
     else   { 
-        open_bracket = strchr(operand, '['); /* Find the opening bracket */
-        close_bracket = strchr(operand, ']'); /* Find the closing bracket */
+        open_bracket = memchr(operand.start, '[', operand.len); /* Find the opening bracket */
+        close_bracket = memchr(operand.start, ']', operand.len); /* Find the closing bracket */
 
         /* Check if both brackets are found and the closing bracket comes after the opening bracket */
         if (open_bracket && close_bracket && open_bracket < close_bracket) {
-            /* Extract and check the index name part */
-            strncpy(name_of_array_index, operand, open_bracket - operand);
-            name_of_array_index[open_bracket - operand] = '\0'; /* Null-terminate the label part */
-            if (!is_label(name_of_array_index, FALSE)) {
-                err = COMMAND_INVALID_INDEX;
+            /* Check the index name part */
+            name_of_array_index = make_span(operand.start, open_bracket - operand.start);
+            if (!is_label(ctx, name_of_array_index, FALSE)) {
+                ctx->err = COMMAND_INVALID_INDEX;
                 return NOT_FOUND;
             }
             else{ /*index label with valid label*/
-                index_label=get_label(symbols_table,name_of_array_index); /*get the label*/
-                if(index_label!=NULL){
-                    if (strcmp(index_label ->property,MDEFINE)==0)
+                index_label = find_label(&ctx->symbols_table, name_of_array_index.start, name_of_array_index.len); /*get the label*/
+                if(index_label!=NO_SYMBOL){
+                    if (SYMBOL_KIND(&ctx->symbols_table, index_label) == SYMBOL_CONSTANT)
                     {
                         return METHOD_INDEX;
                     }
@@ -413,21 +519,79 @@ int detect_method(char * operand)
             }
             
             /*index addressing with numeric*/
-            /* Extract and check the index number part */
-            strncpy(wanted_index, open_bracket + 1, close_bracket - open_bracket - 1);
-            wanted_index[close_bracket - open_bracket - 1] = '\0'; /* Null-terminate the number part */
-            if (!is_number(wanted_index)&& !is_label(wanted_index,FALSE)) { /*if not numer or label inside []*/
-                err = COMMAND_INVALID_INDEX;
+            /* Check the index number part */
+            wanted_index = make_span(open_bracket + 1, close_bracket - open_bracket - 1);
+            if (!is_number(wanted_index)&& !is_label(ctx, wanted_index,FALSE)) { /*if not numer or label inside []*/
+                ctx->err = COMMAND_INVALID_INDEX;
                 return NOT_FOUND;
             }
             return METHOD_INDEX;
             }
     }
     /* If none of the above addressing methods matched, set the error and return NOT_FOUND */
-    err = COMMAND_INVALID_METHOD;
+    ctx->err = COMMAND_INVALID_METHOD;
     return NOT_FOUND;
 }
 
+/* This function decodes an operand, given its addressing method (that was detected by detect_method).
+ * Numbers and constants are decoded to values, and labels to ids of their names (they might be defined later). */
+void decode_operand(assembler_context *ctx, span operand, int method, decoded_operand *op)
+{
+    char *open_bracket, *close_bracket;
+    span part; /* The number/constant of an immediate operand, or the index of an index operand */
+    int const_label;
+
+    op->method = method;
+    op->reg = 0;
+    op->value = 0;
+    op->symbol = NO_SYMBOL;
+    op->index_symbol = NO_SYMBOL;
+
+    switch (method)
+    {
+        case METHOD_IMMEDIATE: /* Extracting immediate number or the value of a constant */
+            part = make_span(operand.start + 1, operand.len - 1);
+            if(is_number(part))
+                op->value = atoi(part.start);
+            else if(is_label(ctx, part, FALSE)) {
+                const_label = find_label(&ctx->symbols_table, part.start, part.len);
+                if(const_label != NO_SYMBOL)
+                    op->value = SYMBOL_VALUE(&ctx->symbols_table, const_label);
+            }
+            else
+                ctx->err = METHOD_IMMEDIATE_INPUT_INVALID;
+            break;
+
+        case METHOD_DIRECT:
+            op->symbol = add_name(ctx, operand.start, operand.len);
+            break;
+
+        case METHOD_INDEX: /* Splitting the operand to the array's name and the index */
+            open_bracket = memchr(operand.start, '[', operand.len);
+            close_bracket = memchr(open_bracket + 1, ']', operand.start + operand.len - open_bracket - 1);
+            if(close_bracket == NULL)
+                close_bracket = operand.start + operand.len;
+            part = make_span(open_bracket + 1, close_bracket - open_bracket - 1);
+
+            op->symbol = add_name(ctx, operand.start, open_bracket - operand.start);
+            op->value = NOT_FOUND;
+            if(is_number(part))
+                op->value = atoi(part.start);
+            else if(is_label(ctx, part, FALSE)) {
+                const_label = find_label(&ctx->symbols_table, part.start, part.len);
+                if(const_label != NO_SYMBOL && SYMBOL_KIND(&ctx->symbols_table, const_label) == SYMBOL_CONSTANT)
+                    op->value = SYMBOL_VALUE(&ctx->symbols_table, const_label);
+                else /* Other labels' addresses are only known after the first pass */
+                    op->index_symbol = add_name(ctx, part.start, part.len);
+            }
+            break;
+
+        case METHOD_REGISTER:
+            op->reg = operand.start[1] - '0'; /* Getting the register's number */
+            break;
+    }
+}
+
 /* This function checks for the validity of given addressing methods according to the opcode */
 boolean command_accept_methods(int type, int first_method, int second_method)
 {
@@ -580,82 +744,77 @@ int num_words(int method)
 }
 
 /* This function handles an .extern directive */
-int handle_extern_directive(char *line)
+int handle_extern_directive(assembler_context *ctx, char *line)
 {
-    char token[LABEL_LENGTH]; /* This will hold the required label */
+    span token; /* This will hold the required label */
 
-    extract_token(token, line); /* Getting the next token */
-    if(end_of_line(token)) /* If the token is empty, then there's no label */
+    extract_token(&token, line); /* Getting the next token */
+    if(token.kind == TOKEN_END) /* If the token is empty, then there's no label */
     {
-        err = EXTERN_NO_LABEL;
+        ctx->err = EXTERN_NO_LABEL;
         return ERROR;
     }
-    if(!is_label(token, FALSE)) /* The token should be a label (without a colon) */
+    if(!is_label(ctx, token, FALSE)) /* The token should be a label (without a colon) */
     {
-        err = EXTERN_INVALID_LABEL;
+        ctx->err = EXTERN_INVALID_LABEL;
         return ERROR;  
     }  
 
     line = next_token(line);
     if(!end_of_line(line))
     {
-        err = EXTERN_TOO_MANY_OPERANDS;
+        ctx->err = EXTERN_TOO_MANY_OPERANDS;
         return ERROR;
     }
 
     /* Trying to add the label to the symbols table */
-    if(add_label(&symbols_table, token, EXTERNAL_DEFAULT_ADDRESS, "extren",TRUE) == NULL)
+    if(add_label(ctx, token.start, token.len, EXTERNAL_DEFAULT_ADDRESS, SYMBOL_EXTERN) == NO_SYMBOL)
         return ERROR;
-    return is_error(); /* Error code might be 1 if there was an error in is_label() */
+    return is_error(ctx); /* Error code might be 1 if there was an error in is_label() */
 }
 
-int handle_define_directive(char *line) {
-    char name[LABEL_LENGTH];
+int handle_define_directive(assembler_context *ctx, char *line) {
+    span name;
     int value;
-    char *token = NULL;
+    char *equals = NULL;
     char *rest_of_line = line;
 
     /* Skip any whitespace following the ".define" directive keyword */
     rest_of_line = skip_spaces(rest_of_line);
 
-    /* Extract the name of the constant */
-    token = strtok(rest_of_line, "="); /* Now token points to the name part before '=' */
-    if (token) {
-        char *temp = token + strlen(token) + 1; /* Move past the end of the token */
-        token = strtok(token, " \t"); /* Remove any trailing spaces from the name */
-        if (token) {
-            strcpy(name, token);
-        } else {
-            err = DEFINE_MISSING_EQUALS;
-            return ERROR;
-        }
-
-        /* Move past spaces and the '=' character in the remaining part of the line */
-        while (temp < rest_of_line + strlen(rest_of_line) && (*temp == ' ' || *temp == '\t')) temp++; /* Skip spaces */
-        if (*temp == '=') temp++; /* Skip the '=' character */
-        while (*temp == ' ' || *temp == '\t') temp++; /* Skip spaces after '=' */
+    /* The name part is before the '=' */
+    equals = strchr(rest_of_line, '=');
+    if (equals == NULL) {
+        ctx->err = DEFINE_MISSING_EQUALS;
+        return ERROR;
+    }
 
-        rest_of_line = temp;
-    } else {
-        err = DEFINE_MISSING_EQUALS;
+    /* Extract the name of the constant (without any trailing spaces) */
+    name = make_span(rest_of_line, strcspn(rest_of_line, " \t="));
+    if (name.len == 0 || name.len > LABEL_LENGTH) {
+        ctx->err = DEFINE_INVALID_LABEL;
         return ERROR;
     }
 
+    /* Move past the '=' character and the spaces after it */
+    rest_of_line = equals + 1;
+    while (*rest_of_line == ' ' || *rest_of_line == '\t') rest_of_line++;
+
 
     /* Extract the value */
     if (sscanf(rest_of_line, "%d", &value) != 1) {
-        err = DEFINE_INVALID_VALUE;
+        ctx->err = DEFINE_INVALID_VALUE;
         return ERROR;
     }
 
     /* Validate the name as a valid label that does not already exist */
-    if (!is_label(name, NO_COLON)) {
-        err = DEFINE_INVALID_LABEL;
+    if (!is_label(ctx, name, NO_COLON)) {
+        ctx->err = DEFINE_INVALID_LABEL;
         return ERROR;
     }
 
-    /* Add the name and value to the symbols table with 'mdefine' property */
-    if (add_label(&symbols_table, name, value, MDEFINE, FALSE, FALSE) == NULL) {
+    /* Add the name and value to the symbols table as a constant */
+    if (add_label(ctx, name.start, name.len, value, SYMBOL_CONSTANT) == NO_SYMBOL) {
         return ERROR;
     }
 
@@ -665,59 +824,50 @@ int handle_define_directive(char *line) {
 /* This function checks whether a given token is a label or not (by syntax).
  * The parameter colon states whether the function should look for a ':' or not
  * when parsing parameter (to make it easier for both kinds of tokens passed to this function.
+ * The token isn't changed, the name of a label with a colon is its first token.len - 1 characters.
  */
-boolean is_label(char *token, int colon)
+boolean is_label(assembler_context *ctx, span token, int colon)
 {
-    boolean has_digits = FALSE; /* If there are digits inside the label, we can easily skip checking if
-                                   it's a command name. */
-    int token_len = strlen(token);
+    int token_len = token.len;
     int i;
 
     /* Checking if token's length is not too short */
-    if(token == NULL ||
-            token_len < (colon ? MINIMUM_LABEL_LENGTH_WITH_COLON: MINIMUM_LABEL_LENGTH_WITHOUT_COLON))
+    if(token_len < (colon ? MINIMUM_LABEL_LENGTH_WITH_COLON: MINIMUM_LABEL_LENGTH_WITHOUT_COLON))
         return FALSE;
 
-    if(colon && token[token_len - 1] != ':') return FALSE; /* if colon = TRUE, there must be a colon at the end */
+    if(colon && token.start[token_len - 1] != ':') return FALSE; /* if colon = TRUE, there must be a colon at the end */
 
     if (token_len > LABEL_LENGTH) {
-        if(colon) err = LABEL_TOO_LONG; /* It's an error only if we search for a label definition */
+        if(colon) ctx->err = LABEL_TOO_LONG; /* It's an error only if we search for a label definition */
         return FALSE;
     }
-    if(!isalpha(*token)) { /* First character must be a letter */
-        if(colon) err = LABEL_INVALID_FIRST_CHAR;
+    if(!isalpha(*token.start)) { /* First character must be a letter */
+        if(colon) ctx->err = LABEL_INVALID_FIRST_CHAR;
         return FALSE;
     }
 
-    if (colon) {
-        token[token_len - 1] = '\0'; /* The following part is more convenient without a colon */
-        token_len--;
-    }
+    if (colon)
+        token_len--; /* The following part is more convenient without a colon */
 	
     /* Check if all characters are digits or letters */
     for(i = 1; i < token_len; i++) /* We have already checked if the first character is ok */
     {
-        if(isdigit(token[i]))
-            has_digits = TRUE;
-        else if(!isalpha(token[i])) {
+        if(!isalnum(token.start[i])) {
             /* It's not a label but it's an error only if someone put a colon at the end of the token */
-            if(colon) err = LABEL_ONLY_ALPHANUMERIC;
+            if(colon) ctx->err = LABEL_ONLY_ALPHANUMERIC;
             return FALSE;
         }
     }
 
-    if(!has_digits) /* It can't be a command */
+    /* Final obstacle: it's a label only if it's not a keyword */
+    switch(classify_keyword(token.start, token_len).kind)
     {
-        if (find_command(token) != NOT_FOUND) {
-            if(colon) err = LABEL_CANT_BE_COMMAND; /* Label can't have the same name as a command */
+        case KEYWORD_COMMAND:
+            if(colon) ctx->err = LABEL_CANT_BE_COMMAND; /* Label can't have the same name as a command */
+            return FALSE;
+        case KEYWORD_REGISTER:
+            if(colon) ctx->err = LABEL_CANT_BE_REGISTER;
             return FALSE;
-        }
-    }
-
-    if(is_register(token)) /* Final obstacle: it's a label only if it's not a register */
-    {
-        if(colon) err = LABEL_CANT_BE_REGISTER;
-        return FALSE;
     }
 
     return TRUE;
@@ -0,0 +1,5 @@
+; A line with an error of the assembler, before an error of the preprocessor: only the preprocessor's error is
+; reported (the assembler doesn't pass over the file), with --stream as well
+MAIN: mov #1, #2
+    hlt
+endmcr
@@ -0,0 +1,25 @@
+; Errors of macros with parameters
+
+; A parameter can't be a register, a command or a directive
+mcr use_reg r1
+    inc r1
+endmcr
+mcr use_cmd mov
+    mov #1, r2
+endmcr
+
+; Two parameters with the same name, and a parameter that isn't a name
+mcr twice a, a
+    add a, r1
+endmcr
+mcr bad_name 1x
+    clr r1
+endmcr
+
+; A macro can't be redefined
+mcr pair src, dst
+    mov src, dst
+endmcr
+mcr pair src
+    clr src
+endmcr
@@ -0,0 +1,8 @@
+; A call of a macro with parameters with too many arguments
+mcr pair src, dst
+    mov src, dst
+endmcr
+
+MAIN: pair r1, r2
+    pair r1, r2, r3
+    hlt
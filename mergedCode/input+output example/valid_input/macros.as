@@ -0,0 +1,26 @@
+; Macros with parameters: every call is expanded with its arguments in the slots of the parameters
+.extern PRINT
+mcr push_pair src, dst
+    mov src, dst
+    add #1, dst
+endmcr
+mcr show x
+    prn x
+    jsr PRINT
+endmcr
+mcr label name, len
+name: .string "name-x-len"
+.data len
+endmcr
+.define SIZE = 4
+MAIN: push_pair r1, r2
+    push_pair #SIZE, LIST
+    show r3
+    show LIST[1]
+    show MSG
+    cmp r2, #SIZE
+    bne MAIN
+    hlt
+label MSG, 3
+LIST: .data 6, -9, SIZE
+.entry MAIN
@@ -0,0 +1,84 @@
+/*=======================================================================================================
+Project: Maman 14 - Assembler
+Created by:
+Edrehy Tal and Liberman Ron Rafail
+
+Date: 18/04/2024
+========================================================================================================= */
+
+#include <string.h>
+
+#include "assembler.h"
+#include "keywords.h"
+
+/* The hash of a 3 letters mnemonic. Its multipliers were searched for so that no 2 of the 16 mnemonics collide,
+ * which makes it a perfect hash: a mnemonic is found with a single probe of the table. */
+#define COMMAND_HASH(token) ((3 * (unsigned char) (token)[0] + 18 * (unsigned char) (token)[1] \
+                             + (unsigned char) (token)[2]) & (COMMAND_SLOTS - 1))
+#define COMMAND_SLOTS 32
+#define COMMAND_LENGTH 3 /* all the mnemonics have 3 letters */
+
+/* The mnemonics by their hash (an empty slot has no name) */
+static const struct {
+    const char *name;
+    int opcode;
+} command_slots[COMMAND_SLOTS] = {
+        {NULL, 0}, {NULL, 0}, {"prn", PRN}, {"cmp", CMP}, {"hlt", HLT}, {NULL, 0}, {"jsr", JSR}, {"bne", BNE},
+        {NULL, 0}, {"dec", DEC}, {NULL, 0}, {"mov", MOV}, {"not", NOT}, {NULL, 0}, {NULL, 0}, {"add", ADD},
+        {NULL, 0}, {"rts", RTS}, {NULL, 0}, {"clr", CLR}, {"red", RED}, {"sub", SUB}, {NULL, 0}, {NULL, 0},
+        {"jmp", JMP}, {NULL, 0}, {"inc", INC}, {NULL, 0}, {NULL, 0}, {NULL, 0}, {NULL, 0}, {"lea", LEA}
+};
+
+/* This function classifies a token (given by its start and length, it doesn't have to be terminated) as a
+ * command, a directive, a register or a plain identifier, by its length and then by its characters */
+keyword classify_keyword(const char *token, int len)
+{
+    keyword result;
+    const char *name = NULL;
+
+    result.kind = KEYWORD_IDENTIFIER;
+    result.value = NOT_FOUND;
+
+    switch (len)
+    {
+        case REGISTER_LENGTH: /* r0 - r7 */
+            if (token[0] == 'r' && token[1] >= '0' + MIN_REGISTER && token[1] <= '0' + MAX_REGISTER) {
+                result.kind = KEYWORD_REGISTER;
+                result.value = token[1] - '0';
+            }
+            return result;
+
+        case COMMAND_LENGTH:
+            name = command_slots[COMMAND_HASH(token)].name;
+            if (name != NULL && memcmp(token, name, COMMAND_LENGTH) == 0) {
+                result.kind = KEYWORD_COMMAND;
+                result.value = command_slots[COMMAND_HASH(token)].opcode;
+            }
+            return result;
+
+        case 5: /* .data */
+            name = ".data";
+            result.value = DATA;
+            break;
+
+        case 6: /* .entry */
+            name = ".entry";
+            result.value = ENTRY;
+            break;
+
+        case 7: /* .string, .extern, .define */
+            switch (token[1])
+            {
+                case 's': name = ".string"; result.value = STRING; break;
+                case 'e': name = ".extern"; result.value = EXTERN; break;
+                case 'd': name = ".define"; result.value = DEFINE; break;
+            }
+            break;
+    }
+
+    if (name != NULL && memcmp(token, name, len) == 0)
+        result.kind = KEYWORD_DIRECTIVE;
+    else
+        result.value = NOT_FOUND;
+    return result;
+}
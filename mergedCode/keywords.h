@@ -0,0 +1,23 @@
+/*=======================================================================================================
+Project: Maman 14 - Assembler
+Created by:
+Edrehy Tal and Liberman Ron Rafail
+
+Date: 18/04/2024
+========================================================================================================= */
+
+#ifndef ASSEMBLER_KEYWORDS_H
+#define ASSEMBLER_KEYWORDS_H
+
+/* The kinds of tokens that the keyword classifier tells apart */
+enum keyword_kinds {KEYWORD_IDENTIFIER, KEYWORD_COMMAND, KEYWORD_DIRECTIVE, KEYWORD_REGISTER};
+
+/* A classified token: its kind, and the opcode / directive type / register number of a keyword */
+typedef struct keyword {
+    int kind; /* one of enum keyword_kinds */
+    int value; /* enum commands for a command, enum directives for a directive, the number of a register */
+} keyword;
+
+keyword classify_keyword(const char *token, int len);
+
+#endif
@@ -0,0 +1,147 @@
+/*=======================================================================================================
+Project: Maman 14 - Assembler
+Created by:
+Edrehy Tal and Liberman Ron Rafail
+
+Date: 18/04/2024
+========================================================================================================= */
+
+#define _POSIX_C_SOURCE 200112L /* fileno */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "line_source.h"
+#include "utils.h"
+#include "stats.h"
+
+/* This function reads the whole file to a buffer of the source and indexes its lines. The size of a regular file is
+ * known, so its buffer is allocated once (with room for the '\0' and for finding the end of the file).
+ * Returns ERR_MEM_ALLOC if there's not enough memory for the text or its lines. */
+status_error_code read_line_source(line_source *source, FILE *fp)
+{
+    struct stat st;
+    char *text, *grown;
+    long length = 0, capacity;
+    size_t n;
+
+    capacity = fstat(fileno(fp), &st) == 0 && S_ISREG(st.st_mode) ? (long) st.st_size + 2 : BUFSIZ;
+    if ((text = (char *) malloc(capacity)) == NULL)
+        return ERR_MEM_ALLOC;
+    count_allocation();
+
+    rewind(fp);
+    do {
+        if (length + 1 >= capacity) { /* Leaving room for the '\0' after the last line */
+            capacity *= 2;
+            grown = (char *) realloc(text, capacity);
+            if (grown == NULL) {
+                free(text);
+                return ERR_MEM_ALLOC;
+            }
+            count_allocation();
+            text = grown;
+        }
+        n = fread(text + length, 1, capacity - length - 1, fp);
+        length += n;
+    } while (n > 0);
+
+    if (index_line_source(source, text, length) != NO_ERROR) {
+        free(text);
+        return ERR_MEM_ALLOC;
+    }
+    source->owned = TRUE;
+    return NO_ERROR;
+}
+
+/* This function builds the offsets of the lines of a text in a single scan, terminating every line with '\0'.
+ * The text isn't copied, it must have room for a '\0' after its last character.
+ * Returns ERR_MEM_ALLOC if there's not enough memory for the offsets (the source is left without lines). */
+status_error_code index_line_source(line_source *source, char *text, long length)
+{
+    char *pos = text, *end = text + length, *eol;
+
+    source->text = text;
+    source->length = length;
+    source->lines = NULL;
+    source->num_lines = source->lines_capacity = 0;
+    source->next = source->text_capacity = 0;
+    source->stream = NULL;
+    source->owned = FALSE;
+    source->failed = FALSE;
+
+    while (pos < end)
+    {
+        if (!ensure_capacity((void **) &source->lines, source->num_lines, &source->lines_capacity, sizeof(long))) {
+            free(source->lines);
+            source->lines = NULL;
+            source->num_lines = source->lines_capacity = 0;
+            return ERR_MEM_ALLOC;
+        }
+        source->lines[source->num_lines++] = pos - text;
+
+        eol = (char *) memchr(pos, '\n', end - pos);
+        if (eol == NULL) /* The last line doesn't end with '\n' */
+            eol = end;
+        *eol = '\0';
+        pos = eol + 1;
+    }
+    return NO_ERROR;
+}
+
+/* This function prepares to read the lines of a file one at a time, so only the current line is kept in memory.
+ * The file is read from its current position. */
+void stream_line_source(line_source *source, FILE *fp)
+{
+    index_line_source(source, NULL, 0); /* An empty text has no lines to allocate, so it can't fail */
+    source->stream = fp;
+    source->owned = TRUE;
+}
+
+/* This function returns the next line of the source (terminated by '\0' in place of its '\n'), or NULL after
+ * the last line. A line of a streamed source is valid only until the next one is read.
+ * NULL is also returned if a streamed line doesn't fit in memory, and then the source is marked as failed. */
+char *next_line(line_source *source)
+{
+    int len = 0;
+
+    if (source->stream == NULL)
+        return source->next < source->num_lines ? LINE_AT(source, source->next++) : NULL;
+
+    while (TRUE) {
+        /* Making sure fgets has room for a character and the '\0' */
+        if (!ensure_capacity((void **) &source->text, len + 1, &source->text_capacity, sizeof(char))) {
+            source->failed = TRUE;
+            return NULL;
+        }
+        if (fgets(source->text + len, source->text_capacity - len, source->stream) == NULL)
+            break; /* The end of the file */
+        len += strlen(source->text + len);
+        if (len > 0 && source->text[len - 1] == '\n') {
+            source->text[len - 1] = '\0';
+            break;
+        }
+    }
+    source->length = len;
+    source->next++;
+    return len > 0 ? source->text : NULL;
+}
+
+/* This function releases the lines offsets, and the text if it belongs to the source */
+void close_line_source(line_source *source)
+{
+    if (source->owned)
+        free(source->text);
+    free(source->lines);
+
+    source->text = NULL;
+    source->lines = NULL;
+    source->length = 0;
+    source->num_lines = source->lines_capacity = 0;
+    source->next = source->text_capacity = 0;
+    source->stream = NULL;
+    source->owned = source->failed = FALSE;
+}
@@ -0,0 +1,39 @@
+/*=======================================================================================================
+Project: Maman 14 - Assembler
+Created by:
+Edrehy Tal and Liberman Ron Rafail
+
+Date: 18/04/2024
+========================================================================================================= */
+
+#ifndef ASSEMBLER_LINE_SOURCE_H
+#define ASSEMBLER_LINE_SOURCE_H
+
+#include <stdio.h>
+#include "structs.h"
+#include "Error_Handler.h"
+
+/* A text split to lines: the lines are read straight from the text, without copying them.
+ * Every line of the text is terminated by '\0' in place of its '\n', so it can be used as a string.
+ * A streamed source doesn't keep the text: every line is read from the file to a buffer when it's asked for. */
+typedef struct line_source {
+    char *text; /* the text of all the lines (a streamed source: the buffer of the current line) */
+    long length; /* number of characters of the text */
+    long *lines; /* offset in the text of the start of each line */
+    int num_lines, lines_capacity; /* number of lines and the size of the offsets array */
+    int next; /* index of the line that next_line returns */
+    int text_capacity; /* size of the buffer of the current line (a streamed source) */
+    FILE *stream; /* the file that the lines are read from (a streamed source), NULL otherwise */
+    boolean owned; /* TRUE if the text should be released when the source is closed */
+    boolean failed; /* TRUE if a streamed line couldn't be read because there wasn't enough memory */
+} line_source;
+
+#define LINE_AT(source, i) ((source)->text + (source)->lines[i]) /* The line with the given index */
+
+status_error_code read_line_source(line_source *source, FILE *fp);
+status_error_code index_line_source(line_source *source, char *text, long length);
+void stream_line_source(line_source *source, FILE *fp);
+char *next_line(line_source *source);
+void close_line_source(line_source *source);
+
+#endif
@@ -0,0 +1,81 @@
+/*=======================================================================================================
+Project: Maman 14 - Assembler
+Created by:
+Edrehy Tal and Liberman Ron Rafail
+
+Date: 18/04/2024
+========================================================================================================= */
+
+#define _POSIX_C_SOURCE 200809L /* open_memstream */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include "log.h"
+
+/* The names of the levels, by their order in enum log_levels */
+static const char *level_names[] = {"quiet", "normal", "verbose", "trace"};
+
+/* This function returns the level with the given name, or -1 if there's no such level */
+int parse_log_level(const char *name)
+{
+    int level;
+
+    for (level = LOG_QUIET; level <= LOG_TRACE; level++)
+        if (strcmp(name, level_names[level]) == 0)
+            return level;
+    return -1;
+}
+
+/* This function writes a progress message of a file (formatted like printf) if the level of its context allows it */
+void log_message(assembler_context *ctx, int level, const char *format, ...)
+{
+    va_list args;
+
+    if (!LOG_ENABLED(ctx, level))
+        return;
+    va_start(args, format);
+    vfprintf(ctx ? ctx->out_stream : stdout, format, args);
+    va_end(args);
+}
+
+/* This function opens a sink whose messages are kept in memory until it's flushed.
+ * If there's not enough memory for it, the messages are written straight to the destination. */
+void open_log_sink(log_sink *sink, FILE *dest)
+{
+    sink->buffer = NULL;
+    sink->size = 0;
+    sink->stream = open_memstream(&sink->buffer, &sink->size);
+    sink->in_memory = sink->stream != NULL;
+    if (!sink->in_memory)
+        sink->stream = dest;
+}
+
+/* This function writes the messages of a sink to the destination at once, and closes the sink */
+void flush_log_sink(log_sink *sink, FILE *dest)
+{
+    if (sink->in_memory) {
+        fclose(sink->stream); /* Completes the buffer */
+        fwrite(sink->buffer, 1, sink->size, dest);
+        free(sink->buffer);
+    }
+    fflush(dest);
+    sink->stream = NULL;
+    sink->buffer = NULL;
+    sink->size = 0;
+}
+
+/* This function closes a sink without writing its messages (the ones that were written straight to the destination,
+ * because it wasn't in memory, are already there) */
+void discard_log_sink(log_sink *sink)
+{
+    if (sink->in_memory) {
+        fclose(sink->stream);
+        free(sink->buffer);
+    }
+    sink->stream = NULL;
+    sink->buffer = NULL;
+    sink->size = 0;
+}
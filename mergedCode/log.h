@@ -0,0 +1,41 @@
+/*=======================================================================================================
+Project: Maman 14 - Assembler
+Created by:
+Edrehy Tal and Liberman Ron Rafail
+
+Date: 18/04/2024
+========================================================================================================= */
+
+#ifndef ASSEMBLER_LOG_H
+#define ASSEMBLER_LOG_H
+
+#include <stdio.h>
+#include "structs.h"
+
+/* The levels of the progress messages. A message is written only if the level of the run is at least its level.
+ * Errors are always written, whatever the level is. */
+enum log_levels {
+    LOG_QUIET, /* nothing but errors */
+    LOG_NORMAL, /* a message for every file (the default) */
+    LOG_VERBOSE, /* the stages of every file */
+    LOG_TRACE /* every line of the preprocessed source and every word of the .ob file */
+};
+
+#define LOG_ENABLED(ctx, level) ((ctx) == NULL || (ctx)->log_level >= (level)) /* Messages without a context are written */
+
+/* A sink that holds the messages of a single file in memory, so each worker thread writes to its own buffer
+ * and the messages of each file are written out together */
+typedef struct log_sink {
+    FILE *stream; /* the stream that the messages are written to */
+    char *buffer; /* the messages that were written so far (owned by the stream until the sink is flushed) */
+    size_t size; /* number of characters of the buffer */
+    boolean in_memory; /* FALSE if a buffer couldn't be opened, and the stream is the destination itself */
+} log_sink;
+
+int parse_log_level(const char *name);
+void log_message(assembler_context *ctx, int level, const char *format, ...);
+void open_log_sink(log_sink *sink, FILE *dest);
+void flush_log_sink(log_sink *sink, FILE *dest);
+void discard_log_sink(log_sink *sink);
+
+#endif
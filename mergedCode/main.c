@@ -6,139 +6,395 @@ Edrehy Tal and Liberman Ron Rafail
 Date: 18/04/2024
 ========================================================================================================= */
 
+#define _POSIX_C_SOURCE 200112L /* pthreads */
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
 #include "structs.h"
 #include "prototypes.h"
 #include "extern_variables.h"
 #include "utils.h"
 #include "Error_Handler.h"
 #include "preprocessor.h"
+#include "log.h"
+#include "stats.h"
 
 
-/* Global  extern variables */
-
-unsigned int data[MACHINE_RAM];
-unsigned int instructions[MACHINE_RAM];
-int ic;
-int dc;
-int err;
-labelPtr symbols_table;
-extPtr ext_list;
-boolean entry_exists, extern_exists, was_error;
-
-const char *commands[] = {
-        "mov", "cmp", "add", "sub", "not", "clr", "lea", "inc", "dec", "jmp", "bne",
-        "red", "prn", "jsr", "rts", "hlt"
-};
-
-const char *directives[] = {
-        ".data", ".string", ".entry", ".extern" ,".define"
-};
-
-void reset_global_vars()
-{
-    symbols_table = NULL;
-    ext_list = NULL;
-
-    entry_exists = FALSE;
-    extern_exists = FALSE;
-    was_error = FALSE;
-}
 #define HANDLE_STATUS(file, code) if ((code) == ERR_MEM_ALLOC) { \
-    handle_preprocessor_error(code, (file)); \
+    handle_preprocessor_error(ctx, code, (file)); \
     if (file) free_file_context(&(file)); \
     return ERR_MEM_ALLOC; \
     }
 
-#define CHECK_ERROR_CONTINUE(report, file) \
-    if ((report) != NO_ERROR) {      \
-    handle_preprocessor_error(ERR_FOUND_ASSEMBLER, (file));\
-        continue;                    \
-    }
-
 /**
  * Processes the input source file for assembler preprocessing.
  *
- * Reads the source file and process it accordingly by the assembler passes and the preprocessor.
-
+ * Reads the source file and preprocesses it into the source buffer of the context, which the assembler passes
+ * read from. The .am file is written only if it was asked for (--keep-am).
+ * When the source is streamed (--stream) the lines are written to the .am file as they're passed to the first pass,
+ * and the file is removed if the preprocessor finds an error.
  *
+ * @param ctx           The context of the file being assembled.
  * @param file_name     The name of the input source file to process.
- * @param dest          Pointer to the destination file_context struct.
+ * @param options       The options of the run.
  * @param index         The index of the file being processed.
  * @param file_number           The total number of files to be processed.
  *
  * @return The status of the file processing.
  * @return NO_ERROR if successful, or FAILURE if an error occurred.
  */
-status_error_code preprocess_file(const char* file_name, file_context** dest , int index, int file_number) {
-    file_context *src = NULL;
+status_error_code preprocess_file(assembler_context *ctx, const char* file_name, const assembler_options *options, int index, int file_number) {
+    file_context *src = NULL, *dest = NULL;
     status_error_code code = NO_ERROR;
 
-    src = create_file_context(file_name, ASSEMBLY_EXT, FILE_EXT_LEN, FILE_MODE_READ, &code);
+    src = create_file_context(ctx, file_name, ASSEMBLY_EXT, FILE_EXT_LEN, FILE_MODE_READ, &code);
     HANDLE_STATUS(src, code);
+    if (code != NO_ERROR) /* The source file couldn't be opened (already reported) */
+        return code;
 
-    handle_preprocessor_progress(OPEN_FILE, src);
+    handle_preprocessor_progress(ctx, OPEN_FILE, src);
 
-    *dest = create_file_context(file_name, PREPROCESSOR_EXT, FILE_EXT_LEN, FILE_MODE_WRITE_PLUS, &code);
-    HANDLE_STATUS(*dest, code);
-    (*dest)->tc = file_number;
-    (*dest)->fc = index;
+    if (options->keep_am && ctx->stream) {
+        dest = create_file_context(ctx, file_name, PREPROCESSOR_EXT, FILE_EXT_LEN, FILE_MODE_WRITE_PLUS, &code);
+        HANDLE_STATUS(dest, code);
+        if (code != NO_ERROR) {
+            free_file_context(&src);
+            return code;
+        }
+        ctx->am_stream = dest->file_ptr;
+    }
 
-    code = assembler_preprocessor(src, *dest);
+    code = assembler_preprocessor(ctx, src);
 
     if (src) free_file_context(&src);
 
     if (code != NO_ERROR) {
-        handle_preprocessor_error(ERR_PRE, index, file_number, file_name);
-        free_file_context(dest);
+        if (dest) { /* The streamed lines are not a complete .am file */
+            fclose(dest->file_ptr);
+            dest->file_ptr = ctx->am_stream = NULL;
+            remove(dest->file_name);
+            free_file_context(&dest);
+        }
+        handle_preprocessor_error(ctx, ERR_PRE, index, file_number, file_name);
         return FAILURE;
-    } else {
-        handle_preprocessor_progress(PRE_FILE_OK, *dest, index, file_number);
-        return NO_ERROR;
     }
+
+    if (options->keep_am) {
+        if (!dest) {
+            dest = create_file_context(ctx, file_name, PREPROCESSOR_EXT, FILE_EXT_LEN, FILE_MODE_WRITE_PLUS, &code);
+            HANDLE_STATUS(dest, code);
+            if (code != NO_ERROR)
+                return code;
+            fwrite(ctx->source.text, 1, ctx->source.len, dest->file_ptr);
+        }
+        ctx->am_stream = NULL;
+        dest->tc = file_number;
+        dest->fc = index;
+        handle_preprocessor_progress(ctx, PRE_FILE_OK, dest, index, file_number);
+        free_file_context(&dest);
+    }
+    return NO_ERROR;
 }
-status_error_code preprocess_file(const char* file_name, file_context** dest , int index, int file_number);
 
-/* This function handles all activities in the program, it receives command line arguments for filenames */
-int main(int argc, char *argv[]){  
-    char *input_filename;
-    FILE *fp;
-    int i;
+/* A single source file of the batch and the result of assembling it */
+typedef struct assembly_job {
+    char *file_name; /* name of the source file (without extension) */
+    int index; /* index of the file in the batch (starts from 1) */
+    log_sink out; /* sink that holds the progress messages of the file */
+    log_sink err; /* sink that holds the error messages of the file */
+    assembler_stats *stats; /* where the statistics of the file are stored, NULL if they aren't reported */
+    status_error_code report; /* result of assembling the file */
+    boolean done; /* flag that the file was assembled */
+} assembly_job;
+
+/* The state that is shared between the worker threads */
+typedef struct worker_pool {
+    assembly_job *jobs; /* all the files of the batch */
+    int num_jobs; /* number of files in the batch */
+    int next_job; /* index of the next file that no worker took yet */
+    const assembler_options *options; /* the options of the run */
+    pthread_mutex_t lock; /* guards next_job and the done flags */
+    pthread_cond_t job_done; /* signaled every time a file is done */
+} worker_pool;
+
+/**
+ * Runs the whole assembling process of a single source file: the preprocessor, and then both passes.
+ *
+ * @param file_name     The name of the input source file (without extension).
+ * @param options       The options of the run.
+ * @param index         The index of the file being processed.
+ * @param file_number   The total number of files to be processed.
+ * @param out_stream    The stream that the progress messages of the file are written to.
+ * @param err_stream    The stream that the error messages of the file are written to.
+ * @param stats         The statistics of the file are stored here, or NULL if they aren't reported (--stats).
+ *
+ * @return NO_ERROR if the file was assembled, or an appropriate error status_error_code otherwise.
+ */
+status_error_code assemble_file(char *file_name, const assembler_options *options, int index, int file_number, FILE *out_stream, FILE *err_stream, assembler_stats *stats)
+{
     status_error_code report;
-    file_context *dest_am = NULL;
-    /*PreProcessor part*/
-    if (argc == 1) {
-        handle_preprocessor_error(FAILURE);
+    assembler_context *ctx;
+    log_sink pass_errors; /* The errors of the streamed first pass */
+
+    ctx = create_assembler_context(out_stream, err_stream);
+    if (!ctx) {
+        handle_preprocessor_error(NULL, ERR_MEM_ALLOC);
+        return ERR_MEM_ALLOC;
+    }
+
+    ctx->log_level = options->log_level;
+    ctx->stream = options->stream;
+    if (stats) {
+        ctx->stats.timed = TRUE;
+        bind_stats(&ctx->stats); /* The allocations of this thread are counted for this file */
+        count_allocation(); /* The context itself */
+    }
+    if (ctx->stream) {
+        start_first_pass(ctx); /* The first pass goes along with the preprocessor */
+        /* Its errors are held until the preprocessor completes, so they're written only when they would be without --stream */
+        open_log_sink(&pass_errors, err_stream);
+        ctx->pass_errors = pass_errors.stream;
+    }
+
+    enter_phase(ctx, PHASE_PREPROCESS);
+    report = preprocess_file(ctx, file_name, options, index, file_number);
+    if (ctx->stream) {
+        if (report == NO_ERROR)
+            flush_log_sink(&pass_errors, err_stream);
+        else
+            discard_log_sink(&pass_errors);
+        ctx->pass_errors = NULL;
+    }
+    if (report != NO_ERROR) {
+        leave_phase(ctx);
+        handle_preprocessor_error(ctx, ERR_FOUND_ASSEMBLER, file_name);
+    }
+    else {
+        log_message(ctx, LOG_VERBOSE, "************* END %s PreProcessor process *************\n\n", file_name);
+
+        log_message(ctx, LOG_VERBOSE, "************* Started %s.am assembling process *************\n\n", file_name);
+
+        enter_phase(ctx, PHASE_FIRST_PASS);
+        if (ctx->stream)
+            end_first_pass(ctx);
+        else
+            first_pass(ctx);
+        free_source(ctx); /* The decoded commands are all that the second pass needs */
+
+        if (!ctx->was_error) /* procceed to second pass */
+            second_pass(ctx, file_name);
+        leave_phase(ctx);
+
+        log_message(ctx, LOG_VERBOSE, "\n\n************* Finished %s.am assembling process *************\n\n", file_name);
+        report = ctx->was_error ? FAILURE : NO_ERROR;
+    }
+
+    if (stats) {
+        *stats = ctx->stats;
+        stats->symbol_lookups = ctx->symbols_table.lookups;
+        bind_stats(NULL);
+    }
+    free_assembler_context(&ctx);
+    return report;
+}
+
+/* This function is run by each worker thread: it takes the next file of the batch until no file is left.
+ * The messages of each file are written to its own sinks in memory, so they stay grouped. */
+void *assembly_worker(void *arg)
+{
+    worker_pool *pool = (worker_pool *) arg;
+    assembly_job *job;
+    int i;
+
+    while (TRUE) {
+        pthread_mutex_lock(&pool->lock);
+        i = pool->next_job++;
+        pthread_mutex_unlock(&pool->lock);
+        if (i >= pool->num_jobs)
+            break;
+
+        job = &pool->jobs[i];
+        open_log_sink(&job->out, stdout);
+        open_log_sink(&job->err, stderr);
+        job->report = assemble_file(job->file_name, pool->options, job->index, pool->num_jobs,
+                                    job->out.stream, job->err.stream, job->stats);
+
+        pthread_mutex_lock(&pool->lock);
+        job->done = TRUE;
+        pthread_cond_broadcast(&pool->job_done);
+        pthread_mutex_unlock(&pool->lock);
+    }
+    return NULL;
+}
+
+/**
+ * Assembles a batch of files on a pool of worker threads.
+ * The messages of the files are written in the order of the files, each file's messages together.
+ *
+ * @param files         The names of the source files (without extension).
+ * @param num_files     The number of files.
+ * @param options       The options of the run (the maximal number of worker threads among them).
+ * @param stats         The statistics of every file are stored here, or NULL if they aren't reported.
+ *
+ * @return TRUE if all the files were assembled without errors, FALSE otherwise.
+ */
+boolean assemble_parallel(char *files[], int num_files, const assembler_options *options, assembler_stats stats[])
+{
+    worker_pool pool;
+    pthread_t *threads;
+    boolean success = TRUE;
+    int i, started;
+
+    pool.jobs = (assembly_job *) malloc(num_files * sizeof(assembly_job));
+    threads = (pthread_t *) malloc(options->num_workers * sizeof(pthread_t));
+    if (!pool.jobs || !threads) {
+        free(pool.jobs);
+        free(threads);
+        handle_preprocessor_error(NULL, ERR_MEM_ALLOC);
+        return FALSE;
+    }
+    for (i = 0; i < num_files; i++) {
+        pool.jobs[i].file_name = files[i];
+        pool.jobs[i].index = i + 1;
+        pool.jobs[i].report = NO_ERROR;
+        pool.jobs[i].done = FALSE;
+        pool.jobs[i].stats = stats ? &stats[i] : NULL;
+    }
+    pool.num_jobs = num_files;
+    pool.next_job = 0;
+    pool.options = options;
+    pthread_mutex_init(&pool.lock, NULL);
+    pthread_cond_init(&pool.job_done, NULL);
+
+    for (started = 0; started < options->num_workers; started++)
+        if (pthread_create(&threads[started], NULL, assembly_worker, &pool) != 0)
+            break;
+    if (started == 0) /* No thread could be created, the files are assembled by this thread */
+        assembly_worker(&pool);
+
+    /* Writing out the messages of each file as soon as it and all the files before it are done */
+    for (i = 0; i < num_files; i++) {
+        pthread_mutex_lock(&pool.lock);
+        while (!pool.jobs[i].done)
+            pthread_cond_wait(&pool.job_done, &pool.lock);
+        pthread_mutex_unlock(&pool.lock);
+
+        flush_log_sink(&pool.jobs[i].out, stdout);
+        flush_log_sink(&pool.jobs[i].err, stderr);
+        if (pool.jobs[i].report != NO_ERROR)
+            success = FALSE;
+    }
+
+    for (i = 0; i < started; i++)
+        pthread_join(threads[i], NULL);
+    pthread_mutex_destroy(&pool.lock);
+    pthread_cond_destroy(&pool.job_done);
+    free(threads);
+    free(pool.jobs);
+    return success;
+}
+
+/* This function handles all activities in the program, it receives command line arguments for filenames.
+ * Usage: assembler [-j N] [--keep-am] [--stream] [-q | -v | --log LEVEL] [--stats[=FORMAT]] file1 file2 ...
+ * -j N assembles up to N files at the same time. --keep-am writes the preprocessed source of each file to its
+ * .am file. --stream passes every preprocessed line to the first pass as soon as it's complete, so the memory
+ * doesn't grow with the size of the source. -q writes only errors, -v the stages of every file as well, and
+ * --log LEVEL sets the level of the messages by its name (quiet, normal, verbose or trace, where trace writes every
+ * line of the preprocessed source and every word of the .ob files). --stats writes a report of the wall and CPU time
+ * of every phase and counters of the work of every file after all the files were assembled, as a table or as JSON
+ * (--stats=table, --stats=json or --stats=csv). The exit status is 0 only if all the files were assembled. */
+int main(int argc, char *argv[]){  
+    char **files, *value;
+    int i, num_files = 0;
+    boolean success = TRUE;
+    assembler_options options;
+    assembler_stats *stats = NULL;
+    double wall = 0, cpu = 0;
+
+    options.num_workers = 1;
+    options.keep_am = FALSE;
+    options.stream = FALSE;
+    options.log_level = LOG_NORMAL;
+    options.stats_format = STATS_NONE;
+
+    files = (char **) malloc(argc * sizeof(char *));
+    if (!files) {
+        handle_preprocessor_error(NULL, ERR_MEM_ALLOC);
         exit(FAILURE);
     }
+
     for (i = 1; i < argc; i++) {
-        report = preprocess_file(argv[i], &dest_am, i, argc - 1);
-        CHECK_ERROR_CONTINUE(report, argv[i]);
-        printf("************* END %s PreProcessor process *************\n\n", argv[i]);
-    }
-
-    for(i = 1; i < argc; i++)
-    {
-        input_filename = create_file_name(argv[i], FILE_AM); /* Appending .as to filename */
-        fp = fopen(input_filename, "r");
-        if(fp != NULL) { /* If file exists */
-            printf("************* Started %s assembling process *************\n\n", input_filename);
-            
-            reset_global_vars();
-            /*PreProceesor(fp)*/
-            first_pass(fp);
-
-            if (!was_error) { /* procceed to second pass */
-                rewind(fp);
-                second_pass(fp, argv[i]);
-            }
-
-            printf("\n\n************* Finished %s assembling process *************\n\n", input_filename);
+        if (strcmp(argv[i], "--keep-am") == 0)
+            options.keep_am = TRUE;
+        else if (strcmp(argv[i], "--stream") == 0)
+            options.stream = TRUE;
+        else if (strcmp(argv[i], "-q") == 0)
+            options.log_level = LOG_QUIET;
+        else if (strcmp(argv[i], "-v") == 0)
+            options.log_level = LOG_VERBOSE;
+        else if (strncmp(argv[i], "--log", 5) == 0 && (argv[i][5] == '\0' || argv[i][5] == '=')) { /* --log LEVEL or --log=LEVEL */
+            value = argv[i][5] ? argv[i] + 6 : (i + 1 < argc ? argv[++i] : "");
+            if ((options.log_level = parse_log_level(value)) < 0)
+                break;
+        }
+        else if (strcmp(argv[i], "--stats") == 0)
+            options.stats_format = STATS_TABLE;
+        else if (strncmp(argv[i], "--stats=", 8) == 0) {
+            if ((options.stats_format = parse_stats_format(argv[i] + 8)) < 0)
+                break;
         }
-        else write_preprocessor_error(CANNOT_OPEN_FILE);
-        free(input_filename);
+        else if (strncmp(argv[i], "-j", 2) == 0) { /* -j N or -jN */
+            value = argv[i][2] ? argv[i] + 2 : (i + 1 < argc ? argv[++i] : "");
+            if ((options.num_workers = atoi(value)) < 1)
+                break;
+        }
+        else
+            files[num_files++] = argv[i];
     }
 
-	return 0;
+    if (i < argc) { /* An invalid option */
+        fprintf(stderr, "Usage: %s [-j N] [--keep-am] [--stream] [-q | -v | --log LEVEL] [--stats[=table|json|csv]] "
+                        "file1 file2 ...\n", argv[0]);
+        free(files);
+        exit(FAILURE);
+    }
+    if (num_files == 0) {
+        handle_preprocessor_error(NULL, FAILURE);
+        free(files);
+        exit(FAILURE);
+    }
+
+    if (options.stats_format != STATS_NONE) {
+        stats = (assembler_stats *) malloc(num_files * sizeof(assembler_stats));
+        if (!stats) {
+            handle_preprocessor_error(NULL, ERR_MEM_ALLOC);
+            free(files);
+            exit(FAILURE);
+        }
+        for (i = 0; i < num_files; i++)
+            init_stats(&stats[i], TRUE);
+        enable_allocation_counting();
+        wall = wall_time();
+        cpu = process_cpu_time();
+    }
+
+    if (options.num_workers > num_files)
+        options.num_workers = num_files;
+    if (options.num_workers > 1)
+        success = assemble_parallel(files, num_files, &options, stats);
+    else {
+        for (i = 0; i < num_files; i++)
+            if (assemble_file(files[i], &options, i + 1, num_files, stdout, stderr, stats ? &stats[i] : NULL) != NO_ERROR)
+                success = FALSE;
+    }
+
+    if (stats) {
+        write_stats(stdout, options.stats_format, files, stats, num_files, options.num_workers,
+                    wall_time() - wall, process_cpu_time() - cpu);
+        free(stats);
+    }
+    free(files);
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
 }
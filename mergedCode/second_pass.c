@@ -10,144 +10,222 @@ Date: 18/04/2024
 #include <string.h>
 #include <stdlib.h>
 #include <ctype.h>
-#include <math.h>
 
 /*--------- Headers ---------*/
 #include "extern_variables.h"
 #include "prototypes.h"
 #include "utils.h"
+#include "log.h"
+#include "stats.h"
 
-void second_pass(FILE *fp, char *filename)
+/* This function manages all the activities of the second pass.
+ * The first pass decoded every command, so now that the symbols table is complete they are encoded to memory
+ * (without parsing the lines again), and the entries are made. */
+void second_pass(assembler_context *ctx, char *filename)
 {
-    char line[LINE_LENGTH]; /* This string will contain each line at a time */
-    int line_num = 1; /* Line numbers start from 1 */
+    enter_phase(ctx, PHASE_SECOND_PASS);
+    encode_instructions(ctx);
+    ctx->stats.words = ctx->ic + ctx->dc;
 
-    ic = 0; /* Initializing global instructions counter */
-
-    while(fgets(line, LINE_LENGTH, fp) != NULL) /* Read lines until end of file */
-    {
-        err = NO_ERROR;
-        if(!ignore(line)) /* Ignore line if it's blank or ; */
-            analyze_line_second_pass(line); /* Analyze one line at a time */
-        if(is_error()) { /* If there was an error in the current line */
-            was_error = TRUE; /* There was at least one error through all the program */
-            write_preprocessor_error(line_num);
-        }
-        line_num++;
-    }
-    if(!was_error) /* Write output files only if there weren't any errors in the program */
-        write_output_files(filename);
+    enter_phase(ctx, PHASE_OUTPUT);
+    /* Write output files only if there weren't any errors in the program */
+    if(!ctx->was_error && write_output_files(ctx, filename) != NO_ERROR)
+        ctx->was_error = TRUE;
 
     /* Free dynamic allocated elements */
-    free_labels(&symbols_table);
-    free_ext(&ext_list);
+    free_labels(&ctx->symbols_table);
+    free_ext_table(&ctx->externals);
+    free_decoded(ctx);
 }
 
-/* This function analyzes and extracts information needed for the second pass from a given line */
-void analyze_line_second_pass(char *line)
+/* This function outputs the error of a line (if there was one) and resets it */
+static void report_line_error(assembler_context *ctx, int line_num)
 {
-    int dir_type, command_type;
-    char current_token[LINE_LENGTH]; /* will hold current token as needed */
-    line = skip_spaces(line); /* Proceeding to first non-blank character */
-    if(end_of_line(line)) return; /* a blank line is not an error */
-
-    extract_token(current_token, line);
-    if(is_label(current_token, COLON)) { /* If it's a label, skip it */
-        line = next_token(line);
-        extract_token(current_token, line);
+    if(is_error(ctx)) {
+        ctx->was_error = TRUE; /* There was at least one error through all the program */
+        write_preprocessor_error(ctx, line_num);
     }
+    ctx->err = NO_ERROR;
+}
+
+/* This function encodes all the decoded commands and makes the entries, in the order of their lines.
+ * Like in the first pass, only the last error of each line is reported. */
+void encode_instructions(assembler_context *ctx)
+{
+    int i = 0, j = 0, line_num = 0;
 
-    if((dir_type = find_directive(current_token)) != NOT_FOUND) /* We need to handle only .entry directive */
+    ctx->ic = 0; /* Initializing instructions counter */
+    ctx->err = NO_ERROR;
+    while(i < ctx->code_len || j < ctx->entries_len)
     {
-        line = next_token(line);
-        if(dir_type == ENTRY)
+        /* Taking whichever of the next command and the next entry comes first */
+        if(j == ctx->entries_len || (i < ctx->code_len && ctx->code[i].line < ctx->entries[j].line))
+        {
+            if(ctx->code[i].line != line_num) {
+                report_line_error(ctx, line_num);
+                line_num = ctx->code[i].line;
+            }
+            encode_instruction(ctx, &ctx->code[i++]);
+        }
+        else
         {
-            extract_token(current_token, line);
-            make_entry(symbols_table, current_token); /* Creating an entry for the symbol */
+            if(ctx->entries[j].line != line_num) {
+                report_line_error(ctx, line_num);
+                line_num = ctx->entries[j].line;
+            }
+            make_entry(ctx, ctx->entries[j].symbol); /* Creating an entry for the symbol */
+            j++;
         }
     }
+    report_line_error(ctx, line_num);
+}
+
+/* This function encodes a decoded command: its first word and then the additional words of its operands */
+void encode_instruction(assembler_context *ctx, decoded_instruction *instruction)
+{
+    decoded_operand *src = &instruction->src, *dest = &instruction->dest;
+    boolean is_src = src->method != METHOD_UNKNOWN, is_dest = dest->method != METHOD_UNKNOWN;
 
-    else if ((command_type = find_command(current_token)) != NOT_FOUND) /* Encoding command's additional words */
+    encode_to_instructions(ctx, build_first_word(instruction->opcode, is_src || is_dest, is_src && is_dest,
+                                                 is_src ? src->method : dest->method, dest->method));
+
+    /* There's a special case where 2 register operands share the same additional word */
+    if(is_src && is_dest && src->method == METHOD_REGISTER && dest->method == METHOD_REGISTER)
+    {
+        encode_to_instructions(ctx, build_register_word(FALSE, src->reg) | build_register_word(TRUE, dest->reg));
+    }
+    else /* It's not the special case */
     {
-        line = next_token(line);
-        handle_command_second_pass(command_type, line);
+        if(is_src) encode_operand(ctx, FALSE, src);
+        if(is_dest) encode_operand(ctx, TRUE, dest);
     }
 }
 
-/* This function writes all 3 output files (if they should be created)*/
-int write_output_files(char *original)
+/* This function writes all 3 output files (if they should be created).
+ * Returns ERROR if an output couldn't be written (there wasn't enough memory, or writing it failed). The outputs of
+ * the program are removed then, so only this program is skipped. */
+int write_output_files(assembler_context *ctx, char *original)
 {
     FILE *file;
+    int status = NO_ERROR;
 
-    file = open_file(original, FILE_OBJECT);
-    write_output_ob(file);
+    file = open_file(ctx, original, FILE_OBJECT);
+    if(file)
+        status = write_output_ob(ctx, file);
 
-    if(entry_exists) {
-        file = open_file(original, FILE_ENTRY);
-        write_output_entry(file);
+    if(status == NO_ERROR && ctx->entry_exists) {
+        file = open_file(ctx, original, FILE_ENTRY);
+        if(file)
+            write_output_entry(ctx, file);
     }
 
-    if(extern_exists)
+    if(status == NO_ERROR && ctx->extern_exists)
     {
-        file = open_file(original, FILE_EXTERN);
-        write_output_extern(file);
+        file = open_file(ctx, original, FILE_EXTERN);
+        if(file)
+            status = write_output_extern(ctx, file);
     }
 
-    return NO_ERROR;
+    if(status == NO_ERROR && ctx->err == OUT_OF_MEMORY) /* The name of an output file couldn't be allocated */
+        status = ERROR;
+    if(status != NO_ERROR)
+        remove_output_files(original);
+    return status;
+}
+
+/* This function removes the output files of a program (the ones that don't exist are skipped) */
+void remove_output_files(char *original)
+{
+    int types[] = {FILE_OBJECT, FILE_ENTRY, FILE_EXTERN}, i;
+    char *filename;
+
+    for(i = 0; i < (int) (sizeof(types) / sizeof(types[0])); i++)
+    {
+        filename = create_file_name(original, types[i]);
+        if(filename)
+        {
+            remove(filename);
+            free(filename);
+        }
+    }
 }
 
 /* This function writes the .ob file output.
  * The first line is the size of each memory (instructions and data).
  * Rest of the lines are: address in the first column, word in memory in the second.
+ * The whole file is formatted to one buffer, which is written at once.
+ * Returns ERROR (after reporting it) if there's not enough memory for the buffer, or if it can't be written.
  */
-void write_output_ob(FILE *fp)
+int write_output_ob(assembler_context *ctx, FILE *fp)
 {
     unsigned int address = MEMORY_START;
     int i;
-    char *converted_base_4;
-    
-    printf("ic: %d, dc: %d\n", ic, dc);
-    fprintf(fp, "%d %d\n", ic, dc); /* First line */
+    char *image, *pos; /* The contents of the file, and the end of what was formatted so far */
+    boolean trace = LOG_ENABLED(ctx, LOG_TRACE); /* Every word is traced only at the trace level */
 
-
-    for (i = 0; i < ic; address++, i++) /* Instructions memory */
+    image = (char *) malloc(2 * OB_LINE_MAX_LENGTH + (ctx->ic + ctx->dc) * OB_LINE_MAX_LENGTH);
+    if(image == NULL)
     {
-        printf("address: %d, instruction: %d\n", address, instructions[i]);
-        converted_base_4 = convert_to_base_4(instructions[i]);
+        handle_preprocessor_error(ctx, ERR_MEM_ALLOC);
+        fclose(fp);
+        return ERROR;
+    }
+    count_allocation();
+    
+    log_message(ctx, LOG_VERBOSE, "ic: %d, dc: %d\n", ctx->ic, ctx->dc);
+    pos = format_decimal(image, (unsigned int) ctx->ic); /* First line */
+    *pos++ = ' ';
+    pos = format_decimal(pos, (unsigned int) ctx->dc);
+    *pos++ = '\n';
 
-        fprintf(fp, "%d\t%s\n", address, converted_base_4);
 
-        free(converted_base_4);
+    for (i = 0; i < ctx->ic; address++, i++) /* Instructions memory */
+    {
+        if (trace)
+            log_message(ctx, LOG_TRACE, "address: %d, instruction: %d\n", address, ctx->instructions[i]);
+        pos = format_decimal(pos, address);
+        *pos++ = '\t';
+        pos = format_base_4(pos, ctx->instructions[i]);
+        *pos++ = '\n';
     }
 
-    for (i = 0; i < dc; address++, i++) /* Data memory */
+    for (i = 0; i < ctx->dc; address++, i++) /* Data memory */
     {
-        printf("address: %d, data: %d\n", address, data[i]);
-        converted_base_4 = convert_to_base_4(data[i]);
-
-        fprintf(fp, "%d\t%s\n", address, converted_base_4);
-
-        free(converted_base_4);
+        if (trace)
+            log_message(ctx, LOG_TRACE, "address: %d, data: %d\n", address, ctx->data[i]);
+        pos = format_decimal(pos, address);
+        *pos++ = '\t';
+        pos = format_base_4(pos, ctx->data[i]);
+        *pos++ = '\n';
     }
 
+    if(!write_buffer(fp, image, pos - image))
+    {
+        handle_preprocessor_error(ctx, ERR_WRITE_FILE, ".ob");
+        free(image);
+        fclose(fp);
+        return ERROR;
+    }
+    free(image);
     fclose(fp);
+    return NO_ERROR;
 }
 
 /* This function writes the output of the .ent file.
  * First column: name of label.
  * Second column: address of definition.
  */
-void write_output_entry(FILE *fp)
+void write_output_entry(assembler_context *ctx, FILE *fp)
 {
-    labelPtr label = symbols_table;
+    symbol_table *table = &ctx->symbols_table;
+    int i;
     /* Go through symbols table and print only symbols that have an entry */
-    while(label)
+    for(i = 0; i < table->count; i++)
     {
-        if(label -> entry)
+        if(table->flags[i] & SYMBOL_ENTRY)
         {
-            fprintf(fp, "%s\t%d\n", label -> name, label -> address);
+            fprintf(fp, "%s\t%d\n", NAME_OF(ctx, table->names[i]), SYMBOL_VALUE(table, i));
         }
-        label = label -> next;
     }
     fclose(fp);
 }
@@ -155,129 +233,87 @@ void write_output_entry(FILE *fp)
 /* This function writes the output of the .ext file.
  * First column: label name.
  * Second column: address where the external label should be replaced.
+ * The uses are grouped by label (in the order of the first uses of the labels), and the whole file is formatted to
+ * one buffer, which is written at once.
+ * The file is empty if the external labels were declared but never used.
+ * Returns ERROR (after reporting it) if there's not enough memory for the buffer, or if it can't be written.
  */
-void write_output_extern(FILE *fp)
+int write_output_extern(assembler_context *ctx, FILE *fp)
 {
-    extPtr node = ext_list;
-    /* Going through external circular linked list and pulling out values */
-    do
+    ext_table *table = &ctx->externals;
+    size_t size = 0, len;
+    int i, j;
+    char *image, *pos; /* The contents of the file, and the end of what was formatted so far */
+    const char *name;
+
+    for(i = 0; i < table->count; i++) /* Every line is the name, a tab, an address and a new line */
+        size += table->externs[i].count * (strlen(NAME_OF(ctx, table->externs[i].name)) + MAX_DECIMAL_LENGTH + 2);
+
+    image = (char *) malloc(size + 1);
+    if(image == NULL)
+    {
+        handle_preprocessor_error(ctx, ERR_MEM_ALLOC);
+        fclose(fp);
+        return ERROR;
+    }
+    count_allocation();
+
+    pos = image;
+    for(i = 0; i < table->count; i++)
+    {
+        name = NAME_OF(ctx, table->externs[i].name);
+        len = strlen(name);
+        for(j = 0; j < table->externs[i].count; j++)
+        {
+            memcpy(pos, name, len);
+            pos += len;
+            *pos++ = '\t';
+            pos = format_decimal(pos, table->externs[i].addresses[j]);
+            *pos++ = '\n';
+        }
+    }
+
+    if(!write_buffer(fp, image, pos - image))
     {
-        fprintf(fp, "%s\t%d\n", node -> name, node -> address); /* Printing to file */
-        node = node -> next;
-    } while(node != ext_list);
+        handle_preprocessor_error(ctx, ERR_WRITE_FILE, ".ext");
+        free(image);
+        fclose(fp);
+        return ERROR;
+    }
+    free(image);
     fclose(fp);
+    return NO_ERROR;
 }
 
 /* This function opens a file with writing permissions, given the original input filename and the
  * wanted file extension (by type)
  */
-FILE *open_file(char *filename, int type)
+FILE *open_file(assembler_context *ctx, char *filename, int type)
 {
     FILE *file;
     filename = create_file_name(filename, type); /* Creating filename with extension */
 
+    if(filename == NULL)
+    {
+        handle_preprocessor_error(ctx, ERR_MEM_ALLOC);
+        ctx->err = OUT_OF_MEMORY;
+        return NULL;
+    }
     file = fopen(filename, "w"); /* Opening file with permissions */
     free(filename); /* Allocated modified filename is no longer needed */
 
     if(file == NULL)
     {
-        err = CANNOT_OPEN_FILE;
+        ctx->err = CANNOT_OPEN_FILE;
         return NULL;
     }
     return file;
 }
 
-/* This function determines if source and destination operands exist by opcode */
-void check_operands_exist(int type, boolean *is_src, boolean *is_dest)
-{
-    switch (type)
-    {
-        case MOV:
-        case CMP:
-        case ADD:
-        case SUB:
-        case LEA:
-            *is_src = TRUE;
-            *is_dest = TRUE;
-            break;
-
-        case NOT:
-        case CLR:
-        case INC:
-        case DEC:
-        case JMP:
-        case BNE:
-        case RED:
-        case PRN:
-        case JSR:
-            *is_src = FALSE;
-            *is_dest = TRUE;
-            break;
-
-        case RTS:
-        case HLT:
-            *is_src = FALSE;
-            *is_dest = FALSE;
-    }
-}
-
-/* This function handles commands for the second pass - encoding additional words */
-int handle_command_second_pass(int type, char *line)
-{
-    char first_op[LINE_LENGTH], second_op[LINE_LENGTH]; /* will hold first and second operands */
-    char *src = first_op, *dest = second_op; /* after the check below, src will point to source and
- *                                              dest to destination operands */
-    boolean is_src = FALSE, is_dest = FALSE; /* Source/destination operands existence */
-    int src_method = METHOD_UNKNOWN, dest_method = METHOD_UNKNOWN; /* Their addressing methods */
-
-    check_operands_exist(type, &is_src, &is_dest);
-
-    /* Extracting source and destination addressing methods */
-    if(is_src)
-        src_method = extract_bits(instructions[ic], SRC_METHOD_START_POS, SRC_METHOD_END_POS);
-    if(is_dest)
-        dest_method = extract_bits(instructions[ic], DEST_METHOD_START_POS, DEST_METHOD_END_POS);
-
-    /* Matching src and dest pointers to the correct operands (first or second or both) */
-    if(is_src || is_dest)
-    {
-        line = next_list_token(first_op, line);
-        if(is_src && is_dest) /* There are 2 operands */
-        {
-            line = next_list_token(second_op, line);
-            next_list_token(second_op, line);
-        }
-        else
-        {
-            dest = first_op; /* If there's only one operand, it's a destination operand */
-            src = NULL;
-        }
-    }
-
-    ic++; /* The first word of the command was already encoded in this IC in the first pass */
-    return encode_additional_words(src, dest, is_src, is_dest, src_method, dest_method);
-}
-
-/* This function encodes the additional words of the operands to instructions memory */
-int encode_additional_words(char *src, char *dest, boolean is_src, boolean is_dest, int src_method,
-                                int dest_method) {
-    /* There's a special case where 2 register operands share the same additional word */
-    if(is_src && is_dest && src_method == METHOD_REGISTER && dest_method == METHOD_REGISTER)
-    {
-        encode_to_instructions(build_register_word(FALSE, src) | build_register_word(TRUE, dest));
-    }
-    else /* It's not the special case */
-    {
-        if(is_src) encode_additional_word(FALSE, src_method, src);
-        if(is_dest) encode_additional_word(TRUE, dest_method, dest);
-    }
-    return is_error();
-}
-
 /* This function builds the additional word for a register operand */
-unsigned int build_register_word(boolean is_dest, char *reg)
+unsigned int build_register_word(boolean is_dest, int reg)
 {
-    unsigned int word = (unsigned int) atoi(reg + 1); /* Getting the register's number */
+    unsigned int word = (unsigned int) reg; /* Getting the register's number */
     /* Inserting it to the required bits (by source or destination operand) */
     if(!is_dest)
         word <<= BITS_IN_REGISTER;
@@ -285,95 +321,60 @@ unsigned int build_register_word(boolean is_dest, char *reg)
     return word;
 }
 
-/* This function encodes a given label (by name) to memory */
-void encode_label(char *label)
+/* This function encodes a given label (by id of its name) to memory */
+void encode_label(assembler_context *ctx, int name)
 {
     unsigned int word; /* The word to be encoded */
+    symbol_table *table = &ctx->symbols_table;
+    int symbol = get_label_of(table, name);
 
-    if(is_existing_label(symbols_table, label)) { /* If label exists */
-        word = get_label_address(symbols_table, label); /* Getting label's address */
+    if(symbol != NO_SYMBOL) { /* If label exists */
+        word = SYMBOL_VALUE(table, symbol); /* Getting label's address */
 
-        if(is_external_label(symbols_table, label)) { /* If the label is an external one */
-            /* Adding external label to external list (value should be replaced in this address) */
-            add_ext(&ext_list, label, ic + MEMORY_START);
+        if(SYMBOL_KIND(table, symbol) == SYMBOL_EXTERN) { /* If the label is an external one */
+            /* Adding the use to the uses of the external label (value should be replaced in this address) */
+            if(!add_ext(&ctx->externals, name, ctx->ic + MEMORY_START))
+                ctx->err = OUT_OF_MEMORY;
+            ctx->stats.ext_references++;
             word = insert_are(word, EXTERNAL);
         }
         else
             word = insert_are(word, RELOCATABLE); /* If it's not an external label, then it's relocatable */
 
-        encode_to_instructions(word); /* Encode word to memory */
+        encode_to_instructions(ctx, word); /* Encode word to memory */
     }
     else /* It's an error */
     {
-        ic++;
-        err = COMMAND_LABEL_DOES_NOT_EXIST;
+        encode_to_instructions(ctx, EMPTY_WORD);
+        ctx->err = COMMAND_LABEL_DOES_NOT_EXIST;
     }
 }
 
-/* This function encodes an additional word to instructions memory, given the addressing method */
-void encode_additional_word(boolean is_dest, int method, char *operand)
+/* This function encodes the additional words of a decoded operand to instructions memory */
+void encode_operand(assembler_context *ctx, boolean is_dest, decoded_operand *op)
 {
-    unsigned int word = EMPTY_WORD; /* An empty word */
-    labelPtr const_label;
+    unsigned int word;
 
-    switch (method)
+    switch (op->method)
     {
-        case METHOD_IMMEDIATE: /* Extracting immediate number */
-            if(is_number(operand+1)){
-                word = (unsigned int) atoi(operand + 1);
-            }
-            else if(is_label(operand + 1, FALSE)){
-                operand = strtok(operand," ");
-                const_label = get_label(symbols_table,operand+1);
-                if(const_label != NULL)
-                    word = (unsigned int) const_label ->address;
-            }
-            else{
-                err = METHOD_IMMEDIATE_INPUT_INVALID;
-            }
-                word = insert_are(word, ABSOLUTE);
-                encode_to_instructions(word);
+        case METHOD_IMMEDIATE:
+            encode_to_instructions(ctx, insert_are((unsigned int) op->value, ABSOLUTE));
             break;
 
         case METHOD_DIRECT:
-            encode_label(operand);
+            encode_label(ctx, op->symbol);
             break;
 
-        case METHOD_INDEX: 
-            word = (unsigned int) get_number(operand);
-            encode_label( get_string_name(operand));
-           
-            word = insert_are(word, ABSOLUTE);
-            encode_to_instructions(word);
-        break;
+        case METHOD_INDEX: /* The array's label and then the index */
+            encode_label(ctx, op->symbol);
+            if(op->index_symbol != NO_SYMBOL) /* The index is the label's value (or 0 if there's no such label) */
+                word = get_label_address(&ctx->symbols_table, op->index_symbol);
+            else
+                word = (unsigned int) op->value;
+            encode_to_instructions(ctx, insert_are(word, ABSOLUTE));
+            break;
 
         case METHOD_REGISTER:
-            word = build_register_word(is_dest, operand);
-            encode_to_instructions(word);
+            encode_to_instructions(ctx, build_register_word(is_dest, op->reg));
     }
 }
-
-char* get_string_name(char* formatted_string) {
-   
-    char* name_end = strchr(formatted_string, '[');
-    if (name_end == NULL) {
-        return NULL;
-    }
-    *name_end = '\0';
-    return formatted_string;
-}
-
-int get_number(char* formatted_string) {
-    char* name_end = strchr(formatted_string, '[');
-    if (name_end == NULL) {
-        return -1;
-    }
-    name_end =strtok(name_end+1,"]");
-    if(is_number(name_end))
-        return atoi(name_end);
-    if(is_label(name_end,FALSE)){
-        return get_label_address(symbols_table,name_end);
-    }
-        
-    return -1;
-}
\ No newline at end of file
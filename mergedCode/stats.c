@@ -0,0 +1,286 @@
+/*=======================================================================================================
+Project: Maman 14 - Assembler
+Created by:
+Edrehy Tal and Liberman Ron Rafail
+
+Date: 18/04/2024
+========================================================================================================= */
+
+#define _POSIX_C_SOURCE 200112L /* clock_gettime, pthreads */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "stats.h"
+
+#define MS(seconds) ((seconds) * 1000.0) /* The times are measured in seconds and reported in milliseconds */
+
+/* The names of the formats, by their order in enum stats_formats */
+static const char *format_names[] = {"none", "table", "json", "csv"};
+
+/* The names of the phases, by their order in enum phases */
+static const char *phase_names[] = {"preprocess", "first_pass", "second_pass", "output"};
+
+/* The statistics of the file that each thread assembles, so allocations are counted without passing the context
+ * down to every function that allocates */
+static pthread_key_t stats_key;
+static boolean counting_allocations = FALSE;
+
+/* This function returns the format with the given name, or -1 if there's no such format */
+int parse_stats_format(const char *name)
+{
+    int format;
+
+    for (format = STATS_TABLE; format <= STATS_CSV; format++)
+        if (strcmp(name, format_names[format]) == 0)
+            return format;
+    return -1;
+}
+
+/* This function initializes empty statistics, whose phases are timed only if it's asked for */
+void init_stats(assembler_stats *stats, boolean timed)
+{
+    int i;
+
+    stats->timed = timed;
+    stats->phase = NO_PHASE;
+    stats->wall_mark = stats->cpu_mark = 0;
+    for (i = 0; i < NUM_PHASES; i++)
+        stats->wall[i] = stats->cpu[i] = 0;
+    stats->lines = stats->macros_expanded = stats->symbols = stats->symbol_lookups = 0;
+    stats->ext_references = stats->words = stats->allocations = 0;
+}
+
+/* This function makes count_allocation() count. It's called once, before any thread is created */
+void enable_allocation_counting(void)
+{
+    counting_allocations = pthread_key_create(&stats_key, NULL) == 0;
+}
+
+/* This function sets the statistics that the allocations of the current thread are counted in (NULL for none) */
+void bind_stats(assembler_stats *stats)
+{
+    if (counting_allocations)
+        pthread_setspecific(stats_key, stats);
+}
+
+/* This function counts a heap allocation in the statistics of the file that the current thread assembles */
+void count_allocation(void)
+{
+    assembler_stats *stats;
+
+    if (!counting_allocations)
+        return;
+    stats = (assembler_stats *) pthread_getspecific(stats_key);
+    if (stats)
+        stats->allocations++;
+}
+
+/* This function returns the wall time in seconds (from an arbitrary point, only differences are meaningful) */
+double wall_time(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+        return 0;
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* This function returns the CPU time of the current thread in seconds */
+static double thread_cpu_time(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+        return 0;
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* This function returns the CPU time of the whole process (all of its threads) in seconds */
+double process_cpu_time(void)
+{
+    return (double) clock() / CLOCKS_PER_SEC;
+}
+
+/* This function starts a phase of assembling a file. The phase that was running (if there's one) ends at the same
+ * moment, so switching between phases (like the preprocessor and the streamed first pass) reads the clocks once */
+void enter_phase(assembler_context *ctx, int phase)
+{
+    assembler_stats *stats = &ctx->stats;
+    double wall, cpu;
+
+    if (!stats->timed)
+        return;
+    wall = wall_time();
+    cpu = thread_cpu_time();
+    if (stats->phase != NO_PHASE) {
+        stats->wall[stats->phase] += wall - stats->wall_mark;
+        stats->cpu[stats->phase] += cpu - stats->cpu_mark;
+    }
+    stats->phase = phase;
+    stats->wall_mark = wall;
+    stats->cpu_mark = cpu;
+}
+
+/* This function ends the phase that is running */
+void leave_phase(assembler_context *ctx)
+{
+    enter_phase(ctx, NO_PHASE);
+}
+
+/* This function adds the statistics of a file to the total statistics */
+static void add_stats(assembler_stats *total, const assembler_stats *stats)
+{
+    int i;
+
+    for (i = 0; i < NUM_PHASES; i++) {
+        total->wall[i] += stats->wall[i];
+        total->cpu[i] += stats->cpu[i];
+    }
+    total->lines += stats->lines;
+    total->macros_expanded += stats->macros_expanded;
+    total->symbols += stats->symbols;
+    total->symbol_lookups += stats->symbol_lookups;
+    total->ext_references += stats->ext_references;
+    total->words += stats->words;
+    total->allocations += stats->allocations;
+}
+
+/* This function writes the times of the phases of a file as 2 rows of the table: wall and CPU time */
+static void write_times_rows(FILE *fp, const char *name, const assembler_stats *stats)
+{
+    double wall = 0, cpu = 0;
+    int i;
+
+    fprintf(fp, "%-20s wall", name);
+    for (i = 0; i < NUM_PHASES; i++) {
+        fprintf(fp, " %12.3f", MS(stats->wall[i]));
+        wall += stats->wall[i];
+    }
+    fprintf(fp, " %12.3f\n%-20s cpu ", MS(wall), "");
+    for (i = 0; i < NUM_PHASES; i++) {
+        fprintf(fp, " %12.3f", MS(stats->cpu[i]));
+        cpu += stats->cpu[i];
+    }
+    fprintf(fp, " %12.3f\n", MS(cpu));
+}
+
+/* This function writes the counters of a file as a row of the table */
+static void write_counters_row(FILE *fp, const char *name, const assembler_stats *stats)
+{
+    fprintf(fp, "%-20s %10lu %10lu %10lu %10lu %10lu %10lu %10lu\n", name, stats->lines, stats->macros_expanded,
+            stats->symbols, stats->symbol_lookups, stats->ext_references, stats->words, stats->allocations);
+}
+
+/* This function writes a string as a JSON string (quoted, with the characters that JSON doesn't allow escaped) */
+static void write_json_string(FILE *fp, const char *str)
+{
+    fputc('"', fp);
+    for (; *str; str++) {
+        if (*str == '"' || *str == '\\')
+            fprintf(fp, "\\%c", *str);
+        else if ((unsigned char) *str < ' ')
+            fprintf(fp, "\\u%04x", (unsigned char) *str);
+        else
+            fputc(*str, fp);
+    }
+    fputc('"', fp);
+}
+
+/* This function writes the statistics of a file as the members of a JSON object */
+static void write_json_members(FILE *fp, const assembler_stats *stats)
+{
+    int i;
+
+    fprintf(fp, "\"phases\": {");
+    for (i = 0; i < NUM_PHASES; i++)
+        fprintf(fp, "%s\"%s\": {\"wall_ms\": %.3f, \"cpu_ms\": %.3f}", i ? ", " : "", phase_names[i],
+                MS(stats->wall[i]), MS(stats->cpu[i]));
+    fprintf(fp, "}, \"counters\": {\"lines\": %lu, \"macros_expanded\": %lu, \"symbols\": %lu, "
+                "\"symbol_lookups\": %lu, \"ext_references\": %lu, \"words\": %lu, \"allocations\": %lu}",
+            stats->lines, stats->macros_expanded, stats->symbols, stats->symbol_lookups, stats->ext_references,
+            stats->words, stats->allocations);
+}
+
+/* This function writes a string as a CSV field (quoted only if it has a character that CSV doesn't allow as is) */
+static void write_csv_field(FILE *fp, const char *str)
+{
+    if (strpbrk(str, ",\"\r\n") == NULL) {
+        fputs(str, fp);
+        return;
+    }
+    fputc('"', fp);
+    for (; *str; str++) {
+        if (*str == '"')
+            fputc('"', fp); /* A quote is escaped by doubling it */
+        fputc(*str, fp);
+    }
+    fputc('"', fp);
+}
+
+/* This function writes the statistics of a file as a row of CSV (in the order of the header of write_stats) */
+static void write_csv_row(FILE *fp, const char *name, const assembler_stats *stats)
+{
+    int i;
+
+    write_csv_field(fp, name);
+    for (i = 0; i < NUM_PHASES; i++)
+        fprintf(fp, ",%.3f,%.3f", MS(stats->wall[i]), MS(stats->cpu[i]));
+    fprintf(fp, ",%lu,%lu,%lu,%lu,%lu,%lu,%lu\n", stats->lines, stats->macros_expanded, stats->symbols,
+            stats->symbol_lookups, stats->ext_references, stats->words, stats->allocations);
+}
+
+/* This function writes the statistics report of a run: the statistics of every file, their total, and the wall and
+ * CPU time of the whole run (with several workers the CPU time is more than the wall time) */
+void write_stats(FILE *fp, int format, char *files[], const assembler_stats stats[], int num_files,
+                 int num_workers, double wall, double cpu)
+{
+    assembler_stats total;
+    int i;
+
+    init_stats(&total, TRUE);
+    for (i = 0; i < num_files; i++)
+        add_stats(&total, &stats[i]);
+
+    if (format == STATS_JSON) {
+        fprintf(fp, "{\"files\": [");
+        for (i = 0; i < num_files; i++) {
+            fprintf(fp, "%s\n  {\"file\": ", i ? "," : "");
+            write_json_string(fp, files[i]);
+            fprintf(fp, ", ");
+            write_json_members(fp, &stats[i]);
+            fprintf(fp, "}");
+        }
+        fprintf(fp, "],\n \"total\": {");
+        write_json_members(fp, &total);
+        fprintf(fp, "},\n \"run\": {\"files\": %d, \"workers\": %d, \"wall_ms\": %.3f, \"cpu_ms\": %.3f}}\n",
+                num_files, num_workers, MS(wall), MS(cpu));
+    }
+    else if (format == STATS_CSV) { /* Only the rows of the files, the total is left to the tools that read it */
+        fprintf(fp, "file");
+        for (i = 0; i < NUM_PHASES; i++)
+            fprintf(fp, ",%s_wall_ms,%s_cpu_ms", phase_names[i], phase_names[i]);
+        fprintf(fp, ",lines,macros_expanded,symbols,symbol_lookups,ext_references,words,allocations\n");
+        for (i = 0; i < num_files; i++)
+            write_csv_row(fp, files[i], &stats[i]);
+    }
+    else if (format == STATS_TABLE) {
+        fprintf(fp, "\n%-25s %12s %12s %12s %12s %12s\n", "time (ms)", "preprocess", "first pass", "second pass",
+                "output", "total");
+        for (i = 0; i < num_files; i++)
+            write_times_rows(fp, files[i], &stats[i]);
+        write_times_rows(fp, "total", &total);
+
+        fprintf(fp, "\n%-20s %10s %10s %10s %10s %10s %10s %10s\n", "counters", "lines", "macros", "symbols",
+                "lookups", "ext refs", "words", "allocs");
+        for (i = 0; i < num_files; i++)
+            write_counters_row(fp, files[i], &stats[i]);
+        write_counters_row(fp, "total", &total);
+
+        fprintf(fp, "\nrun: %d file(s), %d worker(s), wall %.3f ms, cpu %.3f ms\n", num_files, num_workers,
+                MS(wall), MS(cpu));
+    }
+    fflush(fp);
+}
@@ -0,0 +1,35 @@
+/*=======================================================================================================
+Project: Maman 14 - Assembler
+Created by:
+Edrehy Tal and Liberman Ron Rafail
+
+Date: 18/04/2024
+========================================================================================================= */
+
+#ifndef ASSEMBLER_STATS_H
+#define ASSEMBLER_STATS_H
+
+#include <stdio.h>
+#include "structs.h"
+
+/* The formats of the statistics report */
+enum stats_formats {
+    STATS_NONE, /* no report (the default) */
+    STATS_TABLE, /* a table that is easy to read */
+    STATS_JSON, /* a JSON object, for tools that track the numbers over time */
+    STATS_CSV /* a header and a row for every file, for spreadsheets and benchmark series */
+};
+
+int parse_stats_format(const char *name);
+void init_stats(assembler_stats *stats, boolean timed);
+void enable_allocation_counting(void);
+void bind_stats(assembler_stats *stats);
+void count_allocation(void);
+void enter_phase(assembler_context *ctx, int phase);
+void leave_phase(assembler_context *ctx);
+double wall_time(void);
+double process_cpu_time(void);
+void write_stats(FILE *fp, int format, char *files[], const assembler_stats stats[], int num_files,
+                 int num_workers, double wall, double cpu);
+
+#endif
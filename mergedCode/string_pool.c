@@ -0,0 +1,171 @@
+/*=======================================================================================================
+Project: Maman 14 - Assembler
+Created by:
+Edrehy Tal and Liberman Ron Rafail
+
+Date: 18/04/2024
+Description: The pool of the names of a file (labels and macros). Every distinct name is stored once and gets a small
+integer id by the order it was first seen, so the tables and the decoded commands refer to names by their ids, and
+two names are the same name exactly when their ids are equal.
+========================================================================================================= */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "string_pool.h"
+#include "utils.h"
+#include "stats.h"
+
+/* This function initializes an empty pool */
+void init_string_pool(string_pool *pool)
+{
+    pool->chars = NULL;
+    pool->chars_len = pool->chars_capacity = 0;
+    pool->offsets = NULL;
+    pool->hash_next = NULL;
+    pool->count = pool->capacity = 0;
+    pool->buckets = NULL;
+    pool->num_buckets = 0;
+}
+
+/* This function doubles the number of buckets and re-chains the names between them.
+ * Returns FALSE if there's not enough memory (the pool keeps its current buckets). */
+static boolean grow_name_buckets(string_pool *pool)
+{
+    unsigned int new_size = pool->num_buckets ? pool->num_buckets * 2 : NAMES_INITIAL_BUCKETS;
+    int *new_buckets = (int *) malloc(new_size * sizeof(int));
+    unsigned long index;
+    char *name;
+    int id;
+
+    if (!new_buckets)
+        return FALSE;
+    count_allocation();
+
+    for (id = 0; id < (int) new_size; id++)
+        new_buckets[id] = NO_NAME;
+    for (id = 0; id < pool->count; id++) {
+        name = STRING_OF(pool, id);
+        index = hash_name(name, strlen(name)) & (new_size - 1);
+        pool->hash_next[id] = new_buckets[index];
+        new_buckets[index] = id;
+    }
+    free(pool->buckets);
+    pool->buckets = new_buckets;
+    pool->num_buckets = new_size;
+    return TRUE;
+}
+
+/* This function makes room for one more name (its characters, and the slots of its id).
+ * Returns FALSE if there's not enough memory. */
+static boolean reserve_name(string_pool *pool, int len)
+{
+    int new_capacity;
+    void *grown;
+
+    if (pool->chars_len + len + 1 > pool->chars_capacity) {
+        new_capacity = pool->chars_capacity ? pool->chars_capacity * 2 : NAMES_INITIAL_CAPACITY;
+        if (new_capacity < pool->chars_len + len + 1)
+            new_capacity = pool->chars_len + len + 1;
+        grown = realloc(pool->chars, new_capacity);
+        if (grown == NULL)
+            return FALSE;
+        count_allocation();
+        pool->chars = (char *) grown;
+        pool->chars_capacity = new_capacity;
+    }
+    if (pool->count == pool->capacity) {
+        new_capacity = pool->capacity ? pool->capacity * 2 : ARRAY_INITIAL_CAPACITY;
+        grown = realloc(pool->offsets, new_capacity * sizeof(int));
+        if (grown == NULL)
+            return FALSE;
+        count_allocation();
+        pool->offsets = (int *) grown;
+        grown = realloc(pool->hash_next, new_capacity * sizeof(int));
+        if (grown == NULL)
+            return FALSE;
+        count_allocation();
+        pool->hash_next = (int *) grown;
+        pool->capacity = new_capacity;
+    }
+    if (pool->count >= (int) pool->num_buckets) /* Keeping at most one name per bucket on average */
+        return grow_name_buckets(pool) || pool->num_buckets > 0;
+    return TRUE;
+}
+
+/* This function looks up a name in the chain of its hash bucket, and returns its id or NO_NAME */
+static int lookup_name(const string_pool *pool, const char *name, int len, unsigned long hash)
+{
+    const char *stored;
+    int id;
+
+    if (pool->num_buckets == 0)
+        return NO_NAME;
+    for (id = pool->buckets[hash & (pool->num_buckets - 1)]; id != NO_NAME; id = pool->hash_next[id]) {
+        stored = STRING_OF(pool, id);
+        /* strncmp stops at the end of a shorter stored name, so it never reads past the characters of the pool */
+        if (strncmp(stored, name, len) == 0 && stored[len] == '\0')
+            return id;
+    }
+    return NO_NAME;
+}
+
+/* This function returns the id of the name that is the given characters (they don't have to be terminated by '\0'),
+ * adding the name to the pool if it's the first time it's seen. Returns NO_NAME if there's not enough memory. */
+int intern_name(string_pool *pool, const char *name, int len)
+{
+    unsigned long hash = hash_name(name, len), index;
+    int id = lookup_name(pool, name, len, hash);
+
+    if (id != NO_NAME)
+        return id;
+    if (!reserve_name(pool, len))
+        return NO_NAME;
+
+    id = pool->count++;
+    pool->offsets[id] = pool->chars_len;
+    memcpy(pool->chars + pool->chars_len, name, len);
+    pool->chars[pool->chars_len + len] = '\0';
+    pool->chars_len += len + 1;
+
+    index = hash & (pool->num_buckets - 1);
+    pool->hash_next[id] = pool->buckets[index];
+    pool->buckets[index] = id;
+    return id;
+}
+
+/* This function returns the id of the name that is the given characters, or NO_NAME if it was never interned */
+int find_name(const string_pool *pool, const char *name, int len)
+{
+    return lookup_name(pool, name, len, hash_name(name, len));
+}
+
+/* This function makes room in an index by name ids (an array with a slot for every id, like the index of the labels
+ * or the macros by their names) for the ids below needed. The new slots are set to none (the ids aren't indexed).
+ * Returns FALSE if there's not enough memory (the index is left as it was). */
+boolean grow_name_index(int **index, int *capacity, int needed, int none)
+{
+    int *grown, i;
+
+    if (needed <= *capacity)
+        return TRUE;
+    grown = (int *) realloc(*index, needed * sizeof(int));
+    if (grown == NULL)
+        return FALSE;
+    count_allocation();
+    for (i = *capacity; i < needed; i++)
+        grown[i] = none;
+    *index = grown;
+    *capacity = needed;
+    return TRUE;
+}
+
+/* This function frees the pool, which is empty afterwards */
+void free_string_pool(string_pool *pool)
+{
+    free(pool->chars);
+    free(pool->offsets);
+    free(pool->hash_next);
+    free(pool->buckets);
+    init_string_pool(pool);
+}
@@ -0,0 +1,22 @@
+/*=======================================================================================================
+Project: Maman 14 - Assembler
+Created by:
+Edrehy Tal and Liberman Ron Rafail
+
+Date: 18/04/2024
+========================================================================================================= */
+
+#ifndef ASSEMBLER_STRING_POOL_H
+#define ASSEMBLER_STRING_POOL_H
+
+#include "structs.h"
+
+#define STRING_OF(pool, id) ((pool)->chars + (pool)->offsets[id]) /* The name with the given id, terminated by '\0' */
+
+void init_string_pool(string_pool *pool);
+int intern_name(string_pool *pool, const char *name, int len);
+int find_name(const string_pool *pool, const char *name, int len);
+boolean grow_name_index(int **index, int *capacity, int needed, int none);
+void free_string_pool(string_pool *pool);
+
+#endif
@@ -7,68 +7,75 @@ Date: 18/04/2024
 ========================================================================================================= */
 #include <stdio.h>
 #include <stdlib.h>
-#include <string.h>
 
-#include "structs.h"
+#include "utils.h"
+#include "string_pool.h"
 
-/* This function adds a node to the end of the list */
-extPtr add_ext(extPtr *hptr, char *name, unsigned int reference)
+/* This function initializes an empty table of the uses of external labels, whose names are in the given pool */
+void init_ext_table(ext_table *table, string_pool *pool)
 {
-    extPtr t=*hptr;
-    extPtr temp;
-
-    temp=(extPtr) malloc(sizeof(ext));
-    if(!temp)
-    {
-        printf("\nerror, cannot allocate memory\n");
-        exit(1);
-    }
+    table->externs = NULL;
+    table->count = table->capacity = 0;
+    table->pool = pool;
+    table->by_name = NULL;
+    table->by_name_capacity = 0;
+}
 
-    temp -> address = reference;
-    strcpy(temp->name, name);
+/* This function returns the uses of an external label (by the id of its name), adding the label to the end of the
+ * table if it wasn't used before. Returns NULL if there's not enough memory. */
+static ext_uses *get_ext_uses(ext_table *table, int name)
+{
+    ext_uses *uses;
 
-    if(!(*hptr)) /* If the list is empty */
-    {
-        *hptr = temp;
-        temp -> next = temp;
-        temp -> prev = temp;
-        return temp;
-    }
+    if(!grow_name_index(&table->by_name, &table->by_name_capacity, table->pool->capacity, NO_EXT))
+        return NULL;
+    if(table->by_name[name] != NO_EXT)
+        return &table->externs[table->by_name[name]];
 
+    if(!ensure_capacity((void **) &table->externs, table->count, &table->capacity, sizeof(ext_uses)))
+        return NULL;
+    table->by_name[name] = table->count;
+    uses = &table->externs[table->count++];
+    uses->name = name;
+    uses->addresses = NULL;
+    uses->count = uses->capacity = 0;
+    return uses;
+}
 
-    ((*hptr)->prev)->next = temp;
-    temp->next = t;
-    temp->prev = t->prev;
-    (*hptr)->prev = temp;
+/* This function adds a use of an external label (by the id of its name) at the given address, after the other uses
+ * of the label. The addresses grow by doubling, so a use is appended in constant time on average.
+ * Returns FALSE if there's not enough memory. */
+boolean add_ext(ext_table *table, int name, unsigned int address)
+{
+    ext_uses *uses = get_ext_uses(table, name);
 
-    return temp;
+    if(!uses || !ensure_capacity((void **) &uses->addresses, uses->count, &uses->capacity, sizeof(unsigned int)))
+        return FALSE;
+    uses->addresses[uses->count++] = address;
+    return TRUE;
 }
 
-/* This function frees the allocated memory for the list */
-void free_ext(extPtr *hptr)
+/* This function frees the allocated memory for the table of the uses of external labels, and empties it */
+void free_ext_table(ext_table *table)
 {
-    /* Frees the extern list by going over each extern node and free it*/
-    extPtr temp=*hptr;
-    if(temp) {
-        unsigned int last_reference = ((*hptr)->prev)->address;
-        unsigned int reference = 0;
-        do {
-            temp = *hptr;
-            reference = temp->address;
-            *hptr = (*hptr)->next;
-            free(temp);
-        } while (reference != last_reference);
-    }
+    int i;
+    for(i = 0; i < table->count; i++)
+        free(table->externs[i].addresses);
+    free(table->externs);
+    free(table->by_name);
+    init_ext_table(table, table->pool);
 }
 
-/* This function prints the ext list */
-void print_ext(extPtr h)
+/* This function prints the uses of the external labels */
+void print_ext(ext_table *table)
 {
-    extPtr orig=h;
-    do
+    int i, j;
+    for(i = 0; i < table->count; i++)
     {
-        printf("\nname: %s, reference: %d - >", h->name, h->address);
-        h=h->next;
-    } while(h -> address != orig -> address);
+        printf("\nname: %s, references:", STRING_OF(table->pool, table->externs[i].name));
+        for(j = 0; j < table->externs[i].count; j++)
+            printf(" %u", table->externs[i].addresses[j]);
+        printf(" - >");
+    }
     printf("*\n");
-}
\ No newline at end of file
+}
@@ -9,32 +9,192 @@ Date: 18/04/2024
 
 #define STRUCTS_H
 
+#include <stdio.h>
 #include "assembler.h"
 
-extern unsigned int data[]; /* Data array of words */
-extern unsigned int instructions[]; /* Instructions array of words */
-
 typedef enum {FALSE, TRUE} boolean; /* Defining a boolean type (it doesn't exist in ANSI C) */
 
-/* Defining linked list of labels and a pointer to that list */
-typedef struct Labels * labelPtr;
-typedef struct Labels {
-	char name[LABEL_LENGTH]; /* the name of the label */
-	unsigned int address; /* the address of the label */
-	boolean external; /* a boolean type variable to store if the label is extern or not */
-	boolean inActionStatement; /* a boolean type varialbe to store if the label is in an action statement or not */
-	boolean entry; /* a boolean type varialbe to store if the label is entry or not */
-	char property[MAX_Property_length]; /*store the property "code"/data/mdefine*/
-	labelPtr next; /* a pointer to the next label in the list */
-} Labels;
-
-/* Defining a circular double-linked list to store each time the program uses an extern label, and a pointer to that list */
-typedef struct ext * extPtr;
-typedef struct ext {
-    char name[LABEL_LENGTH]; /* the name of the extern label */
-    unsigned int address; /* the address in memory where the external address should be replaced */
-    extPtr next; /* a pointer to the next extern in the list */
-    extPtr prev; /* a pointer to the previous extern in the list */
-} ext;
+/* The kinds of tokens of a line */
+enum token_kinds {TOKEN_END, TOKEN_WORD, TOKEN_COMMA, TOKEN_STRING};
+
+/* Defining a token as a span of the line it was read from. The token isn't copied out of the line,
+ * so it isn't terminated by '\0' and its length must be used */
+typedef struct span {
+    char *start; /* the first character of the token */
+    int len; /* number of characters of the token */
+    int kind; /* one of enum token_kinds (TOKEN_END if there's no token) */
+} span;
+
+/* Defining a pool of names: every distinct name is stored once and identified by a small integer id (the order
+ * it was first seen in), so names are compared by their ids. The ids are indexed by a chained hash table */
+typedef struct string_pool {
+    char *chars; /* the characters of the names, each one terminated by '\0' */
+    int chars_len, chars_capacity; /* number of used characters and the size of chars */
+    int *offsets; /* offset in chars of the name with every id */
+    int *hash_next; /* id of the next name in the same hash bucket (for every id), NO_NAME at the end of a chain */
+    int count, capacity; /* number of names and the size of offsets and hash_next */
+    int *buckets; /* hash buckets, each one is the id of the first name of a chain (NO_NAME if it's empty) */
+    unsigned int num_buckets; /* number of buckets (always a power of 2) */
+} string_pool;
+
+/* Symbols table: the labels are kept in parallel arrays by the order they were defined in (for deterministic output),
+ * so the passes over all of them are sequential scans, and indexed by the ids of their names (a name is looked up
+ * in the names pool, and then its symbol in constant time). A symbol is its index in the arrays.
+ * The kind of a symbol is also its segment, and a symbol keeps its offset in the segment: its value is the offset
+ * plus the base of the segment, so the segments are placed (or moved) by setting their bases */
+typedef struct symbol_table {
+    int *names; /* the id of the name of every symbol in the names pool */
+    unsigned int *offsets; /* the offset of every symbol in its segment (the value of a constant, 0 for an extern) */
+    unsigned char *flags; /* the kind of every symbol (one of enum symbol_kinds) and SYMBOL_ENTRY */
+    unsigned int bases[NUM_SYMBOL_KINDS]; /* the base address of every segment (0 until the segments are placed) */
+    int count, capacity; /* number of symbols and the size of the arrays */
+    string_pool *pool; /* the pool of the names of the labels */
+    int *by_name; /* the symbol of every name id (NO_SYMBOL if the name isn't a label) */
+    int by_name_capacity; /* number of ids that by_name has room for */
+    unsigned long lookups; /* number of times a label was looked up (kept when the table is freed, for --stats) */
+} symbol_table;
+
+/* Defining the uses of an external label: the addresses in memory where its address should be replaced, in the order
+ * of the uses (which is ascending, as they're encoded) */
+typedef struct ext_uses {
+    int name; /* the id of the extern label's name in the names pool */
+    unsigned int *addresses; /* the addresses of the uses */
+    int count, capacity; /* number of uses and the size of the array */
+} ext_uses;
+
+/* Defining the table of the uses of external labels. The uses are grouped by label, and the labels are kept in the
+ * order of their first uses and indexed by the ids of their names, so a use is appended in constant time */
+typedef struct ext_table {
+    ext_uses *externs; /* the used external labels, in the order of their first uses */
+    int count, capacity; /* number of used external labels and the size of the array */
+    string_pool *pool; /* the pool of the names of the labels */
+    int *by_name; /* the index in externs of every name id (NO_EXT if the name isn't of a used external label) */
+    int by_name_capacity; /* number of ids that by_name has room for */
+} ext_table;
+
+/* Defining an operand of a decoded instruction. Labels are referred to by the ids of their names,
+ * since they might only be defined after the instruction */
+typedef struct decoded_operand {
+    unsigned char method; /* the addressing method, METHOD_UNKNOWN if there's no such operand */
+    unsigned char reg; /* the register's number (register addressing) */
+    int value; /* the immediate value (immediate addressing) or a known index (index addressing) */
+    int symbol; /* the id of the label (direct and index addressing), NO_SYMBOL otherwise */
+    int index_symbol; /* the id of an index that is a label which isn't a known constant, NO_SYMBOL otherwise */
+} decoded_operand;
+
+/* Defining a command as it was decoded by the first pass, so it can be encoded without parsing its line again */
+typedef struct decoded_instruction {
+    unsigned char opcode; /* the command's type */
+    decoded_operand src; /* the source operand */
+    decoded_operand dest; /* the destination operand (a single operand is a destination operand) */
+    int line; /* the line of the command (for error messages) */
+} decoded_instruction;
+
+/* Defining an .entry directive, which is made once the symbols table is complete */
+typedef struct entry_ref {
+    int symbol; /* the id of the label's name */
+    int line; /* the line of the directive (for error messages) */
+} entry_ref;
+
+/* Defining a growing text buffer. It keeps its length, so appending to it doesn't scan what's already in it,
+ * and its text is always terminated by '\0' (once something was appended) */
+typedef struct text_buffer {
+    char *text; /* the characters of the buffer (NULL while it's empty) */
+    int len, capacity; /* number of characters in the buffer and its size */
+} text_buffer;
+
+/* Defining a piece of the expansion of a macro with parameters: a chunk of its body or one of its parameters */
+typedef struct macro_piece {
+    int start, len; /* the chunk of the body (offset and number of characters) */
+    int param; /* index of the parameter that is replaced by the argument of the call, NO_PARAM for a chunk */
+} macro_piece;
+
+/* Defining a macro of the preprocessor */
+typedef struct macro {
+    int name; /* the id of the macro's name in the names pool */
+    char *body; /* the text that replaces the macro's name (the buffer it was read to, NULL if it's empty) */
+    int body_len; /* number of characters of the body */
+    int num_params; /* number of parameters (the arguments of a call are separated by commas) */
+    macro_piece *pieces; /* the body split to chunks and parameters, in the arena (NULL if the macro has no parameters) */
+    int num_pieces; /* number of pieces */
+} macro;
+
+/* Macros table: the macros are kept in an array by the order of their definitions and indexed by the ids of their
+ * names, so a word of the source is looked up in the names pool and then its macro in constant time */
+typedef struct macro_table {
+    macro *macros; /* the macros, in the order they were defined */
+    int count, capacity; /* number of macros and the size of the array */
+    int *by_name; /* the index of the macro of every name id (NO_MACRO if the name isn't a macro) */
+    int by_name_capacity; /* number of ids that by_name has room for */
+} macro_table;
+
+/* Defining a chunk of an arena. The objects that were allocated in it follow the chunk in the same block */
+typedef struct arena_chunk {
+    struct arena_chunk *next; /* the chunk that was the current one before this one */
+    size_t size; /* number of bytes for objects in the chunk */
+    size_t used; /* number of bytes that were allocated so far */
+} arena_chunk;
+
+/* Defining an arena: a bump allocator that owns the objects of assembling a single file and releases them together */
+typedef struct arena {
+    arena_chunk *chunks; /* the current chunk (objects are allocated at its end), linked to the older ones */
+} arena;
+
+/* The phases of assembling a file that are timed separately (--stats) */
+enum phases {PHASE_PREPROCESS, PHASE_FIRST_PASS, PHASE_SECOND_PASS, PHASE_OUTPUT, NUM_PHASES};
+
+/* Defining the statistics of assembling a single file: the time of every phase and counters of the work that was done */
+typedef struct assembler_stats {
+    boolean timed; /* flag to measure the time of the phases (counting is cheap, so it's always done) */
+    int phase; /* the phase that is running, NO_PHASE if there's none */
+    double wall_mark, cpu_mark; /* wall and CPU time (in seconds) when the running phase started */
+    double wall[NUM_PHASES], cpu[NUM_PHASES]; /* total wall and CPU time (in seconds) of every phase */
+    unsigned long lines; /* lines of the source file */
+    unsigned long macros_expanded; /* calls of macros that were replaced by their bodies */
+    unsigned long symbols; /* labels that were added to the symbols table */
+    unsigned long symbol_lookups; /* lookups of labels in the symbols table */
+    unsigned long ext_references; /* uses of external labels */
+    unsigned long words; /* words of the memory image (instructions and data) */
+    unsigned long allocations; /* heap allocations (including the ones that grew a buffer) */
+} assembler_stats;
+
+/* The options of a run of the assembler, given in the command line */
+typedef struct assembler_options {
+    int num_workers; /* maximal number of files that are assembled at the same time (-j N) */
+    boolean keep_am; /* flag to write the preprocessed source to the .am file (--keep-am) */
+    boolean stream; /* flag to pass every preprocessed line to the first pass as soon as it's complete (--stream) */
+    int log_level; /* level of the progress messages, one of enum log_levels (-q, -v, --log LEVEL) */
+    int stats_format; /* format of the statistics report, one of enum stats_formats (--stats[=FORMAT]) */
+} assembler_options;
+
+/* Defining the state of assembling a single source file. Every function of the preprocessor and of both passes
+ * receives it, so several files can be assembled at the same time, each one with its own context */
+typedef struct assembler_context {
+    unsigned int data[MACHINE_RAM]; /* Data array of words */
+    unsigned int instructions[MACHINE_RAM]; /* Instructions array of words */
+    int ic, dc; /* ic-instruction counter ; dc-data counter */
+    int err; /* error of the current line */
+    int line_num; /* the current line */
+    text_buffer source; /* the preprocessed source (the text of the .am file) that the passes read */
+    boolean stream; /* flag that the lines of the source are passed to the first pass as soon as they're complete */
+    FILE *am_stream; /* the .am file that the streamed lines are written to, NULL if it isn't kept */
+    FILE *pass_errors; /* the errors of the streamed lines, held until the preprocessor completes (NULL if they aren't) */
+    boolean was_error; /* flag to error exists */
+    arena objects; /* the arena of the pieces of the macros */
+    symbol_table symbols_table; /* table of all the labels */
+    ext_table externals; /* the uses of external labels, grouped by label */
+    decoded_instruction *code; /* the commands that were decoded by the first pass, in their order */
+    int code_len, code_capacity; /* number of decoded commands and the size of the array */
+    entry_ref *entries; /* the .entry directives, in their order */
+    int entries_len, entries_capacity; /* number of entries and the size of the array */
+    string_pool names; /* the names of the labels and the macros (and the ones the commands and entries refer to) */
+    boolean entry_exists, extern_exists; /* flags to exists entry and extern */
+    macro_table macros; /* table of the macros defined in the source */
+    int macro_start; /* flag that the current line starts a macro's definition (it isn't a part of its body) */
+    int log_level; /* level of the progress messages of this file, one of enum log_levels */
+    FILE *out_stream; /* stream of the progress messages of this file */
+    FILE *err_stream; /* stream of the error messages of this file */
+    assembler_stats stats; /* statistics of assembling this file (--stats) */
+} assembler_context;
 
 #endif
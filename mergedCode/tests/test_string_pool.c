@@ -0,0 +1,115 @@
+/*=======================================================================================================
+Project: Maman 14 - Assembler
+Created by:
+Edrehy Tal and Liberman Ron Rafail
+
+Date: 18/04/2024
+Description: Unit tests of the names pool. A name is looked up against the names of its hash bucket, so a long name
+is looked up against a short name that is stored at the very end of the characters of the pool. The characters are
+moved to the end of a page that is followed by an inaccessible one, so reading past them crashes the test.
+========================================================================================================= */
+
+#define _POSIX_C_SOURCE 200112L /* mmap, mprotect */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "../utils.h"
+#include "../string_pool.h"
+
+#define SHORT_NAME "r"
+#define LONG_NAME_LENGTH 40
+
+static int failures = 0;
+
+/* This function reports a failed check */
+static void check(int condition, const char *description)
+{
+    if (!condition) {
+        printf("FAIL: %s\n", description);
+        failures++;
+    }
+}
+
+/* This function writes to name a name of LONG_NAME_LENGTH characters that falls in the same hash bucket as the short
+ * name, so looking it up compares it with the short name */
+static void colliding_long_name(const string_pool *pool, char *name)
+{
+    unsigned long mask = pool->num_buckets - 1, bucket = hash_name(SHORT_NAME, strlen(SHORT_NAME)) & mask;
+    unsigned long n = 0;
+
+    do {
+        memset(name, 'x', LONG_NAME_LENGTH);
+        sprintf(name, "%s%lu", SHORT_NAME, n++);
+        name[strlen(name)] = 'x'; /* The digits are followed by the padding, not by '\0' */
+        name[LONG_NAME_LENGTH] = '\0';
+    } while ((hash_name(name, LONG_NAME_LENGTH) & mask) != bucket);
+}
+
+/* This function looks up a long name against a short name that ends the characters of the pool */
+static void test_long_name_against_short_name_at_end(void)
+{
+    string_pool pool;
+    char name[LONG_NAME_LENGTH + 1];
+    long page_size = sysconf(_SC_PAGESIZE);
+    char *pages, *chars, *heap_chars;
+    int fd, short_id;
+
+    init_string_pool(&pool);
+    check(intern_name(&pool, "MAIN", 4) == 0, "the first name gets the id 0");
+    short_id = intern_name(&pool, SHORT_NAME, strlen(SHORT_NAME));
+    check(short_id == 1, "the second name gets the id 1");
+    colliding_long_name(&pool, name);
+
+    /* Two pages: the characters of the pool end where the second (inaccessible) page starts */
+    fd = open("/dev/zero", O_RDWR);
+    pages = (char *) mmap(NULL, 2 * page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (pages == MAP_FAILED || mprotect(pages + page_size, page_size, PROT_NONE) != 0) {
+        printf("FAIL: the guard page couldn't be mapped\n");
+        failures++;
+        free_string_pool(&pool);
+        return;
+    }
+    chars = pages + page_size - pool.chars_len;
+    memcpy(chars, pool.chars, pool.chars_len);
+    heap_chars = pool.chars;
+    pool.chars = chars;
+
+    check(find_name(&pool, name, LONG_NAME_LENGTH) == NO_NAME, "a long name isn't found by a short name's prefix");
+    check(find_name(&pool, SHORT_NAME, strlen(SHORT_NAME)) == short_id, "the short name is found");
+    check(find_name(&pool, name, strlen(SHORT_NAME)) == short_id, "a prefix of a token is found as the short name");
+
+    pool.chars = heap_chars;
+    munmap(pages, 2 * page_size);
+    free_string_pool(&pool);
+}
+
+/* This function checks that interning a name again gives its id, and that the names are kept */
+static void test_intern_keeps_ids(void)
+{
+    string_pool pool;
+    int first, second;
+
+    init_string_pool(&pool);
+    first = intern_name(&pool, "LOOP", 4);
+    second = intern_name(&pool, "LOOPS", 5);
+    check(first != second, "different names get different ids");
+    check(intern_name(&pool, "LOOP: mov", 4) == first, "a name that was seen keeps its id");
+    check(strcmp(STRING_OF(&pool, second), "LOOPS") == 0, "a name is stored terminated by '\\0'");
+    check(find_name(&pool, "LOO", 3) == NO_NAME, "a prefix of a name isn't the name");
+    free_string_pool(&pool);
+}
+
+int main(void)
+{
+    test_intern_keeps_ids();
+    test_long_name_against_short_name_at_end();
+    if (failures == 0)
+        printf("string_pool: all the tests passed\n");
+    return failures == 0 ? 0 : 1;
+}
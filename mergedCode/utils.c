@@ -6,91 +6,117 @@ Edrehy Tal and Liberman Ron Rafail
 Date: 18/04/2024
 ========================================================================================================= */
 
+#define _POSIX_C_SOURCE 200112L /* write, fileno */
+
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
 #include <stdlib.h>
-#include <math.h>
+#include <errno.h>
+#include <unistd.h>
 
 #include "prototypes.h"
 #include "assembler.h"
 #include "extern_variables.h"
 #include "utils.h"
-
-const char base4[4] = {
-        '*','#','%','!'};
-
-/* This function extracts bits, given start and end positions of the bit-sequence (0 is LSB) */
-unsigned int extract_bits(unsigned int word, int start, int end)
+#include "PreProcessor.h"
+#include "log.h"
+#include "stats.h"
+#include "arena.h"
+#include "string_pool.h"
+
+/* The base 4 digits of every byte (4 digits of 2 bits each), computed by the preprocessor */
+#define BASE4_DIGIT(d) ((d) == 0 ? '*' : (d) == 1 ? '#' : (d) == 2 ? '%' : '!')
+#define BASE4_BYTE(n) {BASE4_DIGIT(((n) >> 6) & 3), BASE4_DIGIT(((n) >> 4) & 3), \
+                       BASE4_DIGIT(((n) >> 2) & 3), BASE4_DIGIT((n) & 3)}
+#define BASE4_BYTES_4(n) BASE4_BYTE(n), BASE4_BYTE((n) + 1), BASE4_BYTE((n) + 2), BASE4_BYTE((n) + 3)
+#define BASE4_BYTES_16(n) BASE4_BYTES_4(n), BASE4_BYTES_4((n) + 4), BASE4_BYTES_4((n) + 8), BASE4_BYTES_4((n) + 12)
+#define BASE4_BYTES_64(n) BASE4_BYTES_16(n), BASE4_BYTES_16((n) + 16), BASE4_BYTES_16((n) + 32), BASE4_BYTES_16((n) + 48)
+
+static const char base4_bytes[256][4] = {
+        BASE4_BYTES_64(0), BASE4_BYTES_64(64), BASE4_BYTES_64(128), BASE4_BYTES_64(192)
+};
+
+/* Writing a word as 7 digits in base 4 (not terminated by '\0'), returns a pointer to the end of the digits.
+ * The low byte of the word gives the last 4 digits and the 6 bits above it give the first 3. */
+char *format_base_4(char *dest, unsigned int num)
 {
-    unsigned int result;
-    int length = end - start + 1; /* Length of bit-sequence */
-    unsigned int mask = (int) pow(2, length) - 1; /* Creating a '111...1' mask with above line's length */
-
-    mask <<= start; /* Moving mask to place of extraction */
-    result = word & mask; /* The bits are now in their original position, and the rest is 0's */
-    result >>= start; /* Moving the sequence to LSB */
-    return result;
+    const char *high = base4_bytes[(num >> 8) & 0x3F], *low = base4_bytes[num & 0xFF];
+
+    dest[0] = high[1]; /* MSB */
+    dest[1] = high[2];
+    dest[2] = high[3];
+    dest[3] = low[0];
+    dest[4] = low[1];
+    dest[5] = low[2];
+    dest[6] = low[3]; /* LSB */
+    return dest + base4_SEQUENCE_LENGTH;
 }
 
-/* Converting a word to 2 digits in base 4 (as a string) */
-char *convert_to_base_4(unsigned int num)
+/* Writing a number in decimal (not terminated by '\0'), returns a pointer to the end of the digits */
+char *format_decimal(char *dest, unsigned int num)
 {
-    char *base4_seq = (char *) malloc(base4_SEQUENCE_LENGTH);
-
-    /* To convert from binary to base 4 we simply takes 2 bits for each digit */
-    base4_seq[0] = base4[extract_bits(num, 12, 13)]; /* MSB*/
-    base4_seq[1] = base4[extract_bits(num, 10, 11)];
-    base4_seq[2] = base4[extract_bits(num, 8, 9)];
-    base4_seq[3] = base4[extract_bits(num, 6, 7)];
-    base4_seq[4] = base4[extract_bits(num, 4, 5)];
-    base4_seq[5] = base4[extract_bits(num, 2, 3)];
-    base4_seq[6] = base4[extract_bits(num, 0, 1)];/*LSB*/
-    base4_seq[7] = '\0';
+    char digits[MAX_DECIMAL_LENGTH];
+    int n = 0;
+
+    do {
+        digits[n++] = (char) ('0' + num % 10);
+        num /= 10;
+    } while (num > 0);
+    while (n > 0)
+        *dest++ = digits[--n];
+    return dest;
+}
 
-    return base4_seq;
+/* This function writes a whole buffer to a file with as few system calls as possible (usually one) */
+boolean write_buffer(FILE *fp, const char *buffer, size_t length)
+{
+    ssize_t written;
+    int fd;
+
+    fflush(fp); /* Nothing that was written through the stream may come after the buffer */
+    fd = fileno(fp);
+    while (length > 0) {
+        written = write(fd, buffer, length);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return FALSE;
+        }
+        buffer += written;
+        length -= written;
+    }
+    return TRUE;
 }
 
-/* This function checks if a string is a number (all digits) */
-boolean is_number(char *seq)
+/* This function checks if a token is a number (all digits) */
+boolean is_number(span token)
 {
-    if(end_of_line(seq)) return FALSE;
+    char *seq = token.start, *end = token.start + token.len;
+
+    if(token.len == 0) return FALSE;
     if(*seq == '+' || *seq == '-') /* a number can contain a plus or minus sign */
     {
         seq++;
-        if(!isdigit(*seq++)) return FALSE; /* but not only a sign */
+        if(seq == end || !isdigit(*seq)) return FALSE; /* but not only a sign */
     }
 
     /* Check that the rest of the token is made of digits */
-    while(!end_of_line(seq))
+    while(seq < end)
     {
         if(!isdigit(*seq++)) return FALSE;
     }
     return TRUE;
 }
 
-/* This function checks if a given sequence is a valid string (wrapped with "") */
-boolean is_string(char *string)
+/* This function checks if a given token is a valid string (wrapped with "") */
+boolean is_string(span token)
 {
-    if(string == NULL) return FALSE;
-
-    if (*string == '"') /* starts with " */
-        string++;
-    else
-        return FALSE;
-
-    while (*string && *string != '"') { /* Goes until end of string */
-        string++;
-    }
-
-    if (*string != '"') /* a string must end with " */
-        return FALSE;
-
-    string++;
-    if (*string != '\0') /* string token must end after the ending " */
+    if(token.len < 2 || *token.start != '"') /* starts with " */
         return FALSE;
 
-    return TRUE;
+    /* The first " after the opening one must end the token */
+    return memchr(token.start + 1, '"', token.len - 1) == token.start + token.len - 1;
 }
 
 /* This function inserts given A/R/E 2 bits into given info bit-sequence (the info is being shifted left) */
@@ -99,15 +125,14 @@ unsigned int insert_are(unsigned int info, int are)
     return (info << BITS_IN_ARE) | are; /* OR operand allows insertion of the 2 bits because 1 + 0 = 1 */
 }
 
-/* This function creates a file name by appending suitable extension (by type) to the original string */
+/* This function creates a file name by appending suitable extension (by type) to the original string.
+ * Returns NULL if there's not enough memory. */
 char *create_file_name(char *original, int type)
 {
     char *modified = (char *) malloc(strlen(original) + MAX_EXTENSION_LENGTH);
     if(modified == NULL)
-    {
-        fprintf(stderr, "Dynamic allocation error.");
-        exit(ERROR);
-    }
+        return NULL;
+    count_allocation();
 
     strcpy(modified, original); /* Copying original filename to the bigger string */
 
@@ -138,64 +163,81 @@ char *create_file_name(char *original, int type)
 }
 
 /* This function inserts a given word to instructions memory */
-void encode_to_instructions(unsigned int word)
+void encode_to_instructions(assembler_context *ctx, unsigned int word)
 {
-    instructions[ic++] = word;
+    ctx->instructions[ctx->ic++] = word;
 }
 
-/* This functions returns 1 if there's an error (AKA: global variable err has changed) */
-int is_error()
+/* This functions returns 1 if there's an error (AKA: the context's err has changed) */
+int is_error(assembler_context *ctx)
 {
-    return err != NO_ERROR;
+    return ctx->err != NO_ERROR;
 }
 
 
-/* This function copies the next token of a list (comma separated e.x. 1, "abc", 4) to a dest array.
+/* This function makes a span of the given characters of a line */
+span make_span(char *start, int len)
+{
+    span token;
+    token.start = start;
+    token.len = len;
+    token.kind = len > 0 ? TOKEN_WORD : TOKEN_END;
+    return token;
+}
+
+/* This function reads the next token of a list (comma separated e.x. 1, "abc", 4) as a span of the line.
  * Returns a pointer to the first character after the token
  */
-char *next_list_token(char *dest, char *line)
+char *next_list_token(span *token, char *line)
 {
-    char *temp = dest;
+    token->start = line;
+    token->len = 0;
+    token->kind = TOKEN_END;
 
-    if(end_of_line(line)) /* If the given line is empty, copy an empty token */
-    {
-        dest[0] = '\0';
+    if(end_of_line(line)) /* If the given line is empty, there's no token */
         return NULL;
-    }
 
     if(isspace(*line)) /* If there are spaces in the beginning of the token, skip them */
         line = skip_spaces(line);
+    token->start = line;
 
     if(*line == ',') /* A comma deserves a separate, single-character token */
     {
-        strcpy(dest, ",");
+        token->len = 1;
+        token->kind = TOKEN_COMMA;
         return ++line;
     }
 
-    /* Manually copying token until a ',', whitespace or end of line */
+    /* The token goes until a ',', whitespace or end of line */
     while(!end_of_line(line) && *line != ',' && !isspace(*line))
-    {
-        *temp = *line;
-        temp++;
         line++;
-    }
-    *temp = '\0';
+    token->len = line - token->start;
+    if(token->len > 0)
+        token->kind = TOKEN_WORD;
 
     return line;
 }
 
-/* This function copies supposedly next string into dest array and returning a pointer to the
- * first character after it
+/* This function reads supposedly next string as a span of the line: it goes from the opening quotation mark to the
+ * end of the first list token that ends with a quotation mark. Returns a pointer to the first character after it
  */
-char *next_token_string(char *dest, char *line)
+char *next_token_string(span *token, char *line)
 {
-    char temp[LINE_LENGTH];
-    line = next_list_token(dest, line);
-    if(*dest != '"') return line;
-    while(!end_of_line(line) && dest[strlen(dest) - 1] != '"')
+    span part;
+    char *last; /* The last character of the string so far */
+
+    line = next_list_token(token, line);
+    if(token->kind != TOKEN_WORD || *token->start != '"') return line;
+
+    token->kind = TOKEN_STRING;
+    last = token->start + token->len - 1;
+    while(!end_of_line(line) && *last != '"')
     {
-        line = next_list_token(temp, line);
-        if(line) strcat(dest, temp);
+        line = next_list_token(&part, line);
+        if(part.len > 0) {
+            last = part.start + part.len - 1;
+            token->len = last + 1 - token->start;
+        }
     }
     return line;
 }
@@ -216,53 +258,21 @@ char *next_token(char *seq)
     return seq;
 }
 
-/* This function copies the next token (until a space or end of line) to a destination string */
-void extract_token(char *dest, char *line)
-{
-    int i = 0;
-    if(dest == NULL || line == NULL) return;
-
-    while(i < LINE_LENGTH && !isspace(line[i]) && line[i] != '\0') /* Copying token until its end to *dest */
-    {
-        dest[i] = line[i];
-        i++;
-    }
-    dest[i] = '\0';
-}
-
-/* This function finds an index of a string in an array of strings */
-int find_index(char *token, const char *arr[], int n)
-{
-    int i;
-    for(i = 0; i < n; i++)
-        if (strcmp(token, arr[i]) == 0)
-            return i;
-    return NOT_FOUND;
-}
-
-/* Check if a token matches a register name */
-boolean is_register(char *token)
-{
-    /* A register must have 2 characters, the first is 'r' and the second is a number between 0-7 */
-    return strlen(token) == REGISTER_LENGTH && token[0] == 'r' &&
-            token[1] >= '0' &&
-            token[1] <= '7';
-}
-
-/* Check if a token matches a directive name */
-int find_directive(char *token)
-{
-    if(token == NULL || *token != '.') return NOT_FOUND;
-    return find_index(token, directives, NUM_DIRECTIVES);
-}
-
-/* Check if a token matches a command name */
-int find_command(char *token)
+/* This function reads the next token (until a space or end of line) as a span of the line.
+ * Returns a pointer to the first character after the token
+ */
+char *extract_token(span *token, char *line)
 {
-    int token_len = strlen(token);
-    if(token_len > MAX_COMMAND_LENGTH || token_len < MIN_COMMAND_LENGTH)
-        return NOT_FOUND;
-    return find_index(token, commands, NUM_COMMANDS);
+    token->start = line;
+    token->len = 0;
+    token->kind = TOKEN_END;
+    if(line == NULL) return NULL;
+
+    while(!isspace(line[token->len]) && line[token->len] != '\0') /* The token goes until its end */
+        token->len++;
+    if(token->len > 0)
+        token->kind = TOKEN_WORD;
+    return line + token->len;
 }
 
 /* This function skips spaces of a string and returns a pointer to the first non-blank character */
@@ -289,6 +299,7 @@ int ignore(char *line)
  * Creates a file context object, add extension to file name,
  * and opens the file in the specified mode.
  *
+ * @param ctx The context of the file being assembled (for error reporting).
  * @param file_name The name of the file.
  * @param ext The extension to append to the file name.
  * @param ext_len The length of the extension.
@@ -296,7 +307,7 @@ int ignore(char *line)
  * @param report Pointer to the status_error_code report variable.
  * @return A pointer to the created file context object if successful, NULL otherwise.
  */
-file_context* create_file_context(const char* file_name, char* ext, size_t ext_len, char* mode, status_error_code *report) {
+file_context* create_file_context(assembler_context *ctx, const char* file_name, char* ext, size_t ext_len, char* mode, status_error_code *report) {
      file_context* fc = NULL;
     FILE* file = NULL;
     char *file_name_w_ext = NULL;
@@ -307,6 +318,7 @@ file_context* create_file_context(const char* file_name, char* ext, size_t ext_l
         *report = ERR_MEM_ALLOC;
         return NULL; /* Directly return NULL to indicate failure */
     }
+    count_allocation();
 
     /* Calculate length needed for the file name with extension, including space for null terminator */
     len = strlen(file_name) + ext_len + 1;
@@ -316,6 +328,7 @@ file_context* create_file_context(const char* file_name, char* ext, size_t ext_l
         free(fc); /* Free the allocated file_context structure */
         return NULL; /* Early return if memory allocation fails */
     }
+    count_allocation();
 
     /* Construct the full file name with its extension */
     strcpy(file_name_w_ext, file_name);
@@ -329,6 +342,7 @@ file_context* create_file_context(const char* file_name, char* ext, size_t ext_l
         free(fc); /* Free the allocated file_context structure */
         return NULL; /* Early return if memory allocation fails */
     }
+    count_allocation();
     strcpy(fc->file_name_wout_ext, file_name);
 
     /* Duplicate the constructed file name with extension to fc->file_name */
@@ -340,12 +354,13 @@ file_context* create_file_context(const char* file_name, char* ext, size_t ext_l
         free(fc); /* Free the allocated file_context structure */
         return NULL; /* Early return if memory allocation fails */
     }
+    count_allocation();
     strcpy(fc->file_name, file_name_w_ext);
 
     /* Attempt to open the file with the constructed file name */
     file = fopen(fc->file_name, mode);
     if (file == NULL) {
-        handle_preprocessor_error(ERR_OPEN_FILE, fc);
+        handle_preprocessor_error(ctx, ERR_OPEN_FILE, fc);
         *report = ERR_OPEN_FILE;
         free(fc->file_name); /* Free the file name string */
         free(fc->file_name_wout_ext); /* Free the version without extension */
@@ -404,7 +419,7 @@ size_t get_word_length(char **ptr) {
 status_error_code copy_string(char** target, const char* source) {
     char* temp = NULL;
     if (!source) {
-        handle_preprocessor_error(TERMINATE, "copy_string()");
+        handle_preprocessor_error(NULL, TERMINATE, "copy_string()");
         return TERMINATE;
     }
 
@@ -414,10 +429,11 @@ status_error_code copy_string(char** target, const char* source) {
 
     temp = malloc(strlen(source) + 1);
     if (!temp) {
-        handle_preprocessor_error(ERR_MEM_ALLOC);
+        handle_preprocessor_error(NULL, ERR_MEM_ALLOC);
         return ERR_MEM_ALLOC;
     }
 
+    count_allocation();
     strcpy(temp, source);
     temp[strlen(source)] = '\0';
 
@@ -425,39 +441,6 @@ status_error_code copy_string(char** target, const char* source) {
     return NO_ERROR;
 }
 
-/**
- * Copy the first count characters from a source string to target string,
- * and allocate memory to target according to source.
- *
- * @param target  Target string.
- * @param source  Source string.
- * @param count number of characters to copy
- *
- * @return status_error_code, NO_ERROR in case of no error otherwise else the error status_error_code.
- */
-status_error_code copy_n_string(char** target, const char* source, size_t count) {
-    char* temp = NULL;
-    if (!source) {
-        handle_preprocessor_error(TERMINATE, "copy_n_string()");
-        return TERMINATE;
-    }
-
-    temp = malloc(count + 1);
-    if (!temp) {
-        handle_preprocessor_error(ERR_MEM_ALLOC);
-        return ERR_MEM_ALLOC;
-    }
-    strncpy(temp, source, count);
-    temp[count] = '\0';
-
-    if (!*target)*target = NULL;
-
-    if (!*target) free(*target);
-
-    *target = temp;
-    return NO_ERROR;
-}
-
 /**
  * Frees the memory occupied by a file_context structure.
  * Closes the file pointer if it's open and frees the dynamically allocated file name.
@@ -478,4 +461,203 @@ void free_file_context(file_context** context) {
         free(*context);
         *context = NULL;
     }
-}
\ No newline at end of file
+}
+
+/**
+ * Creates a new assembler context with empty tables and counters.
+ *
+ * @param out_stream The stream that progress messages of the file are written to.
+ * @param err_stream The stream that error messages of the file are written to.
+ * @return A pointer to the created context, or NULL if there's not enough memory.
+ */
+assembler_context *create_assembler_context(FILE *out_stream, FILE *err_stream) {
+    assembler_context *ctx = (assembler_context *) malloc(sizeof(assembler_context));
+    if (ctx == NULL)
+        return NULL;
+
+    ctx->ic = 0;
+    ctx->dc = 0;
+    ctx->err = NO_ERROR;
+    ctx->line_num = 0;
+    init_text(&ctx->source);
+    ctx->stream = FALSE;
+    ctx->am_stream = NULL;
+    ctx->pass_errors = NULL;
+    ctx->was_error = FALSE;
+    init_arena(&ctx->objects);
+    init_string_pool(&ctx->names);
+    init_labels(&ctx->symbols_table, &ctx->names);
+    init_ext_table(&ctx->externals, &ctx->names);
+    ctx->code = NULL;
+    ctx->code_len = ctx->code_capacity = 0;
+    ctx->entries = NULL;
+    ctx->entries_len = ctx->entries_capacity = 0;
+    ctx->entry_exists = FALSE;
+    ctx->extern_exists = FALSE;
+    init_macros(&ctx->macros);
+    ctx->macro_start = 0;
+    ctx->log_level = LOG_NORMAL;
+    ctx->out_stream = out_stream;
+    ctx->err_stream = err_stream;
+    init_stats(&ctx->stats, FALSE);
+    return ctx;
+}
+
+/**
+ * Frees an assembler context and everything that is still owned by it
+ * (its symbols, its external references, the arena of its macros, its names pool and its decoded commands).
+ *
+ * @param ctx The context to be freed, set to NULL afterwards.
+ */
+void free_assembler_context(assembler_context **ctx) {
+    if (*ctx != NULL) {
+        free_labels(&(*ctx)->symbols_table);
+        free_ext_table(&(*ctx)->externals);
+        free_decoded(*ctx);
+        free_source(*ctx);
+        free_macros(*ctx);
+        free_arena(&(*ctx)->objects);
+        free_string_pool(&(*ctx)->names);
+        free(*ctx);
+        *ctx = NULL;
+    }
+}
+
+/**
+ * Makes sure a growing array has room for one more element, doubling its capacity if it's full.
+ *
+ * @param array         Pointer to the array (may point to NULL).
+ * @param length        The number of elements in the array.
+ * @param capacity      Pointer to the number of elements the array can hold, updated if it grows.
+ * @param element_size  The size of an element.
+ * @return TRUE if the array has room, FALSE if there's not enough memory (the array is left as it was).
+ */
+boolean ensure_capacity(void **array, int length, int *capacity, size_t element_size) {
+    void *grown;
+    int new_capacity;
+
+    if (length < *capacity)
+        return TRUE;
+    new_capacity = *capacity ? *capacity * 2 : ARRAY_INITIAL_CAPACITY;
+    grown = realloc(*array, new_capacity * element_size);
+    if (grown == NULL)
+        return FALSE;
+    count_allocation();
+    *array = grown;
+    *capacity = new_capacity;
+    return TRUE;
+}
+
+/**
+ * Interns a name in the names pool of a context. A name that was already seen keeps its id.
+ *
+ * @param ctx   The assembler context (its error is OUT_OF_MEMORY if the name couldn't be added).
+ * @param name  The characters of the name (they don't have to be terminated by '\0').
+ * @param len   The number of characters of the name.
+ * @return The id of the name, see NAME_OF, or NO_NAME if there's not enough memory.
+ */
+int add_name(assembler_context *ctx, const char *name, int len) {
+    int id = intern_name(&ctx->names, name, len);
+    if (id == NO_NAME)
+        ctx->err = OUT_OF_MEMORY;
+    return id;
+}
+
+/**
+ * Hashes a name given its length (djb2), for the hash table of the names pool.
+ *
+ * @param name  The characters of the name (they don't have to be terminated by '\0').
+ * @param len   The number of characters of the name.
+ * @return The hash of the name.
+ */
+unsigned long hash_name(const char *name, int len) {
+    unsigned long hash = 5381;
+    while (len-- > 0)
+        hash = ((hash << 5) + hash) + (unsigned char) *name++;
+    return hash;
+}
+
+/**
+ * Initializes an empty text buffer.
+ *
+ * @param buffer The text buffer.
+ */
+void init_text(text_buffer *buffer) {
+    buffer->text = NULL;
+    buffer->len = buffer->capacity = 0;
+}
+
+/**
+ * Appends characters to a text buffer, doubling its size if they don't fit.
+ * The text is always terminated by '\0'.
+ *
+ * @param buffer The text buffer.
+ * @param text   The characters to append (they don't have to be terminated by '\0').
+ * @param len    The number of characters to append.
+ * @return NO_ERROR, or ERR_MEM_ALLOC if the buffer couldn't grow.
+ */
+status_error_code append_text(text_buffer *buffer, const char *text, int len) {
+    int new_capacity;
+    char *grown;
+
+    if (buffer->len + len + 1 > buffer->capacity) {
+        new_capacity = buffer->capacity ? buffer->capacity * 2 : TEXT_INITIAL_CAPACITY;
+        if (new_capacity < buffer->len + len + 1)
+            new_capacity = buffer->len + len + 1;
+        grown = (char *) realloc(buffer->text, new_capacity);
+        if (grown == NULL)
+            return ERR_MEM_ALLOC;
+        count_allocation();
+        buffer->text = grown;
+        buffer->capacity = new_capacity;
+    }
+    memcpy(buffer->text + buffer->len, text, len);
+    buffer->len += len;
+    buffer->text[buffer->len] = '\0';
+    return NO_ERROR;
+}
+
+/**
+ * Frees a text buffer, which is empty afterwards.
+ *
+ * @param buffer The text buffer.
+ */
+void free_text(text_buffer *buffer) {
+    free(buffer->text);
+    init_text(buffer);
+}
+
+/**
+ * Appends text to the preprocessed source of a context.
+ *
+ * @param ctx   The assembler context.
+ * @param text  The characters to append (they don't have to be terminated by '\0').
+ * @param len   The number of characters to append.
+ * @return NO_ERROR, or ERR_MEM_ALLOC if the buffer couldn't grow.
+ */
+status_error_code append_source(assembler_context *ctx, const char *text, int len) {
+    return append_text(&ctx->source, text, len);
+}
+
+/**
+ * Frees the preprocessed source of a context.
+ *
+ * @param ctx The assembler context.
+ */
+void free_source(assembler_context *ctx) {
+    free_text(&ctx->source);
+}
+
+/**
+ * Frees the decoded commands and the entries of a context (the names they refer to stay in its names pool).
+ *
+ * @param ctx The assembler context.
+ */
+void free_decoded(assembler_context *ctx) {
+    free(ctx->code);
+    free(ctx->entries);
+    ctx->code = NULL;
+    ctx->entries = NULL;
+    ctx->code_len = ctx->code_capacity = 0;
+    ctx->entries_len = ctx->entries_capacity = 0;
+}
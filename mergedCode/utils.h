@@ -9,62 +9,73 @@ Date: 18/04/2024
 #define ASSEMBLER_UTILS_H
 #include "structs.h"
 #include "Error_Handler.h"
+#include "string_pool.h"
 
 
 #define FILE_EXT_LEN 3 /* .as */
 #define MAX_LINE_LENGTH 80 /* 80 - Using strlen */
 #define MAX_BUFFER_LENGTH 256
 
+/* The streams that the messages of a file are written to (the standard ones when there's no context) */
+#define OUT_STREAM(ctx) ((ctx) ? (ctx)->out_stream : stdout)
+#define ERR_STREAM(ctx) ((ctx) ? (ctx)->err_stream : stderr)
+
 #define FILE_MODE_READ "r"
 #define FILE_MODE_WRITE_PLUS "w+"
 #define ASSEMBLY_EXT ".as"
 #define PREPROCESSOR_EXT  ".am"
 
 /* Helper functions that are used for parsing tokens and navigating through them */
-char *next_token_string(char *dest, char *line);
-char *next_list_token(char *dest, char *line);
+span make_span(char *start, int len);
+char *next_token_string(span *token, char *line);
+char *next_list_token(span *token, char *line);
 char *next_token(char *seq);
 char *skip_spaces(char *ch);
-void extract_token(char *dest, char *line);
+char *extract_token(span *token, char *line);
 int end_of_line(char *line);
 int ignore(char *line);
 
 /* Helper functions that are used to determine types of tokens */
-int find_index(char *token, const char *arr[], int n);
-int find_command(char *token);
-int find_directive(char *token);
-boolean is_string(char *string);
-boolean is_number(char *seq);
-boolean is_register(char *token);
+boolean is_string(span token);
+boolean is_number(span token);
 
 /* Helper functions that are used for creating files and assigning required extensions to them */
 char *create_file_name(char *original, int type);
-FILE *open_file(char *filename, int type);
-char *convert_to_base_4(unsigned int num);
+FILE *open_file(assembler_context *ctx, char *filename, int type);
+char *format_base_4(char *dest, unsigned int num);
+char *format_decimal(char *dest, unsigned int num);
+boolean write_buffer(FILE *fp, const char *buffer, size_t length);
 
-/* Functions of external labels positions' linked list */
-extPtr add_ext(extPtr *hptr, char *name, unsigned int reference);
-void free_ext(extPtr *hptr);
-void print_ext(extPtr h);
+/* Functions of the table of the uses of external labels */
+void init_ext_table(ext_table *table, string_pool *pool);
+boolean add_ext(ext_table *table, int name, unsigned int address);
+void free_ext_table(ext_table *table);
+void print_ext(ext_table *table);
 
 /* Functions of symbols table */
-labelPtr add_label(labelPtr *hptr, char *name, unsigned int address, char *property,boolean external, ...);
-int delete_label(labelPtr *hptr, char *name);
-void free_labels(labelPtr *hptr);
-void offset_addresses(labelPtr label, int num, boolean is_data);
-unsigned int get_label_address(labelPtr h, char *name);
-labelPtr get_label(labelPtr h, char *name);
-boolean is_existing_label(labelPtr h, char *name);
-boolean is_external_label(labelPtr h, char *name);
-int make_entry(labelPtr h, char *name);
-void print_labels(labelPtr h);
+#define SYMBOL_KIND(table, symbol) ((table)->flags[symbol] & SYMBOL_KIND_MASK) /* One of enum symbol_kinds */
+/* The value of a symbol: its offset in its segment, relocated to the base of the segment */
+#define SYMBOL_VALUE(table, symbol) ((table)->offsets[symbol] + (table)->bases[SYMBOL_KIND(table, symbol)])
+void init_labels(symbol_table *table, string_pool *pool);
+int add_label(assembler_context *ctx, const char *name, int len, unsigned int offset, int kind);
+void define_label(symbol_table *table, int symbol, unsigned int offset, int kind);
+int delete_label(symbol_table *table, int symbol);
+void free_labels(symbol_table *table);
+void set_segment_base(symbol_table *table, int kind, unsigned int base);
+unsigned int get_label_address(symbol_table *table, int name);
+int get_label(symbol_table *table, char *name);
+int find_label(symbol_table *table, const char *name, int len);
+int get_label_of(symbol_table *table, int name);
+boolean is_existing_label(symbol_table *table, char *name);
+boolean is_external_label(symbol_table *table, char *name);
+int make_entry(assembler_context *ctx, int name);
+void print_labels(symbol_table *table);
 
 /* Functions that handle errors */
-int is_error();
+int is_error(assembler_context *ctx);
 
 /* Helper functions for encoding and building words */
-unsigned int extract_bits(unsigned int word, int start, int end);
-void encode_to_instructions(unsigned int word);
+void encode_to_instructions(assembler_context *ctx, unsigned int word);
 unsigned int insert_are(unsigned int info, int are);
 
 
@@ -81,8 +92,24 @@ typedef struct {
 
 void free_file_context(file_context** context);
 
+assembler_context *create_assembler_context(FILE *out_stream, FILE *err_stream);
+void free_assembler_context(assembler_context **ctx);
+
+/* Functions of the decoded commands, the entries and the names pool of a context */
+#define NAME_OF(ctx, id) STRING_OF(&(ctx)->names, id) /* The name with the given id in the names pool of a context */
+boolean ensure_capacity(void **array, int length, int *capacity, size_t element_size);
+int add_name(assembler_context *ctx, const char *name, int len);
+unsigned long hash_name(const char *name, int len);
+void free_decoded(assembler_context *ctx);
+
+/* Functions of growing text buffers and of the preprocessed source of a context */
+void init_text(text_buffer *buffer);
+status_error_code append_text(text_buffer *buffer, const char *text, int len);
+void free_text(text_buffer *buffer);
+status_error_code append_source(assembler_context *ctx, const char *text, int len);
+void free_source(assembler_context *ctx);
+
 size_t get_word_length(char **ptr);
 status_error_code copy_string(char** target, const char* source);
-status_error_code copy_n_string(char** target, const char* source, size_t count);
-file_context* create_file_context(const char* file_name, char* ext, size_t ext_len, char* mode, status_error_code *report);
+file_context* create_file_context(assembler_context *ctx, const char* file_name, char* ext, size_t ext_len, char* mode, status_error_code *report);
 #endif
\ No newline at end of file